@@ -43,12 +43,29 @@ SOURCES += \
     camerathread.cpp \
     camera.cpp \
     dataprocess.cpp \
-    dataprocessthread.cpp \
     dht11thread.cpp \
     netconfigwidget.cpp \
     WzSerialPort.cpp \
     serialcomm.cpp \
-    imageuploader.cpp
+    imageuploader.cpp \
+    yuvconvert.cpp \
+    framepool.cpp \
+    framemailbox.cpp \
+    framestats.cpp \
+    framepairer.cpp \
+    framering.cpp \
+    motiondetector.cpp \
+    roicrop.cpp \
+    jpegcrop.cpp \
+    videoview.cpp \
+    sensorhandle.cpp \
+    sensorscheduler.cpp \
+    dht11reader.cpp \
+    drivermanager.cpp \
+    iiosensor.cpp \
+    rangefilter.cpp \
+    sensorhistory.cpp \
+    monotonic.cpp
 
 
 HEADERS += \
@@ -59,12 +76,29 @@ HEADERS += \
     ui_camera.h \
     device.h \
     dataprocess.h \
-    dataprocessthread.h \
     dht11thread.h \
     netconfigwidget.h \
     WzSerialPort.h \
     serialcomm.h \
-    imageuploader.h
+    imageuploader.h \
+    yuvconvert.h \
+    framepool.h \
+    framemailbox.h \
+    framestats.h \
+    framepairer.h \
+    framering.h \
+    motiondetector.h \
+    roicrop.h \
+    jpegcrop.h \
+    videoview.h \
+    sensorhandle.h \
+    sensorscheduler.h \
+    dht11reader.h \
+    drivermanager.h \
+    iiosensor.h \
+    rangefilter.h \
+    sensorhistory.h \
+    monotonic.h
 
 
 FORMS += \
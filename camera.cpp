@@ -14,8 +14,14 @@ camera::camera(QWidget *parent)
             this, &camera::errorshowslot);
     connect(this, &camera::Show_complete,
             camerathread, &cameraThread::startCapture);
-    connect(camerathread, &cameraThread::imageReady,
+    // 预览帧经邮箱交给 GUI：只保留最新一帧，界面卡顿时旧帧直接丢弃
+    previewBox = new FrameMailbox(this);
+    connect(camerathread, &cameraThread::previewReady,
+            previewBox, &FrameMailbox::post, Qt::DirectConnection);
+    connect(previewBox, &FrameMailbox::frameAvailable,
             this, &camera::videoDisplay);
+    camerathread->setPreviewSize(ui->cameraLabel->size());
+    camerathread->setConsumerRate(RatePreview, DEFAULT_FPS);
     camerathread->start();
 }
 
@@ -26,20 +32,20 @@ camera::~camera()
 
 void camera::errorshowslot()
 {
+    ui->cameraLabel->clear();
     ui->cameraLabel->setText(
         tr("摄像头初始化失败，请检查是否插好，并重新启动！")
     );
 }
 
-void camera::videoDisplay(const QImage &frame)
+void camera::videoDisplay()
 {
-    // 直接在 QLabel 显示最新帧
-    ui->cameraLabel->setPixmap(
-        QPixmap::fromImage(frame
-            .scaled(ui->cameraLabel->size(),
-                    Qt::KeepAspectRatio,
-                    Qt::SmoothTransformation))
-    );
+    QImage frame;
+    FrameInfo info;
+    if (!previewBox->take(&frame, &info)) return;
+    // 预览帧已按控件尺寸生成，直接显示
+    ui->cameraLabel->setFrame(frame);
+    camerathread->stats()->frameDisplayed(info);
 }
 
 void camera::on_startButton_clicked()
@@ -5,6 +5,7 @@
 #include <QImage>
 #include <QPushButton>
 #include "camerathread.h"
+#include "framemailbox.h"
 #include "ui_camera.h"
 
 class camera : public QWidget {
@@ -16,7 +17,7 @@ public:
 
 private slots:
     void errorshowslot();
-    void videoDisplay(const QImage &frame);
+    void videoDisplay();
     void on_startButton_clicked();
 
 signals:
@@ -25,5 +26,6 @@ signals:
 private:
     Ui::camera *ui;
     cameraThread *camerathread;
+    FrameMailbox *previewBox;
     bool cameraflag = false;
 };
@@ -1,91 +1,347 @@
 // camerathread.cpp
 
 #include "camerathread.h"
+#include "yuvconvert.h"
+#include "monotonic.h"
 #include <QDebug>
+#include <QMetaMethod>
+#include <QBuffer>
+#include <QImageReader>
+#include <QElapsedTimer>
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <stdint.h>
 #include <linux/videodev2.h>
 #include <unistd.h>
 
 #define CLEAR(x) memset(&(x), 0, sizeof(x))
 
+// linux/dma-buf.h 的同步接口（内核 4.6 起），旧工具链头文件里没有
+#ifndef DMA_BUF_IOCTL_SYNC
+struct dma_buf_sync {
+    __u64 flags;
+};
+#define DMA_BUF_SYNC_READ   (1 << 0)
+#define DMA_BUF_SYNC_START  (0 << 2)
+#define DMA_BUF_SYNC_END    (1 << 2)
+#define DMA_BUF_IOCTL_SYNC  _IOW('b', 0, struct dma_buf_sync)
+#endif
+
+CaptureConfig CaptureConfig::fromEnvironment()
+{
+    CaptureConfig config;
+    QByteArray io = qgetenv("CAMERA_IO").toLower();
+    if (io == "userptr")     config.memory = CaptureUserPtr;
+    else if (io == "dmabuf") config.memory = CaptureDmaBuf;
+    bool ok = false;
+    int depth = qgetenv("CAMERA_BUFFERS").toInt(&ok);
+    if (ok) config.queueDepth = depth;
+    QList<QByteArray> still = qgetenv("CAMERA_STILL").toLower().split('x');
+    if (still.size() == 2) config.stillSize = QSize(still[0].toInt(), still[1].toInt());
+    return config;
+}
+
+static CaptureConfig makeConfig(const QSize &size, int fps)
+{
+    CaptureConfig config = CaptureConfig::fromEnvironment();
+    config.size = size;
+    config.fps  = fps;
+    return config;
+}
+
 cameraThread::cameraThread(QObject *parent)
+  : cameraThread(CaptureConfig::fromEnvironment(), parent)
+{
+}
+
+cameraThread::cameraThread(const QSize &size, int fps, QObject *parent)
+  : cameraThread(makeConfig(size, fps), parent)
+{
+}
+
+cameraThread::cameraThread(const CaptureConfig &config, QObject *parent)
   : QThread(parent)
+  , device(config.device)
+  , requestSize(config.size)
+  , requestFps(config.fps)
+  , memory(config.memory)
+  , requestDepth(qBound(MIN_QUEUE_DEPTH, config.queueDepth, (int)VIDEO_MAX_FRAME))
 {
-    // 分配RGB888缓冲
-    rgbBuffer = (unsigned char*)malloc(IMAGE_WIDTH * IMAGE_HEIGHT * 3);
-    if (!rgbBuffer) {
-        qCritical() << "Failed to malloc rgbBuffer";
-        emit errorshow();
-        return;
+    // 唤醒事件：暂停/恢复/退出时打断阻塞的 poll
+    wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakefd < 0) {
+        qCritical() << "eventfd failed:" << strerror(errno);
     }
+    for (int i = 0; i < RateConsumerCount; ++i) consumerRates[i] = 0;
+    qDebug() << "YUYV->RGB888 kernel:" << yuyvKernelName();
+    qRegisterMetaType<FrameInfo>("FrameInfo");
+    qRegisterMetaType<RingFrame>("RingFrame");
+
     // 打开并初始化设备
     if (openAndInitDevice() < 0) {
         qCritical() << "Camera init failed";
         emit errorshow();
+        return;
+    }
+    selectStillMode(config.stillSize);
+
+    if (config.ringMs > 0) frameRing = new FrameRing(config.ringMs, RING_BUCKETS);
+
+    // 按协商出的分辨率预分配RGB888帧池
+    framePool = FramePool::create(FRAME_POOL_SLOTS, rgbStride() * height);
+    if (!framePool) {
+        qCritical() << "Failed to allocate frame pool";
+        emit errorshow();
     }
 }
 
 cameraThread::~cameraThread()
 {
-    stopCaptureInternal();
+    stop();
+    wait();
+    if (streaming) stopCaptureInternal();
     uninitVideo();
     if (videofd >= 0) closeVideo(videofd);
-    if (buffers)   free(buffers);
-    if (rgbBuffer) free(rgbBuffer);
+    if (wakefd >= 0)  closeVideo(wakefd);
+    delete frameRing;
+    // 仍被 GUI 持有的帧归还后池才会真正释放
+    if (framePool)   framePool->release();
+    if (previewPool) previewPool->release();
+}
+
+void cameraThread::setPreviewSize(const QSize &size)
+{
+    QMutexLocker locker(&previewLock);
+    previewSize    = size;
+    previewCurrent = false;
+}
+
+void cameraThread::setConsumerRate(RateConsumer consumer, int fps)
+{
+    if (consumerRates[consumer].exchange(qMax(fps, 0)) == qMax(fps, 0)) return;
+    rateDirty = true;
+    wakeup();
+}
+
+void cameraThread::setSkipStillPreview(bool skip)
+{
+    skipStillPreview = skip;
+}
+
+bool cameraThread::sharpestRecentFrame(RingFrame *frame)
+{
+    return frameRing && frameRing->sharpest(frame, monotonicUs());
+}
+
+void cameraThread::requestFullFrame()
+{
+    fullFrameRequests++;
+}
+
+bool cameraThread::snapshot(QImage *image, FrameInfo *info, int timeoutMs)
+{
+    QMutexLocker locker(&snapshotLock);
+    // 只有在采集时才值得请求并等待新帧
+    qint64 freshUs = monotonicUs() - SNAPSHOT_MAX_AGE_MS * 1000LL;
+    if (capturing && (snapshotImage.isNull() || snapshotInfo.dequeuedUs < freshUs)) {
+        requestFullFrame();
+        QElapsedTimer timer;
+        timer.start();
+        while (snapshotImage.isNull() || snapshotInfo.dequeuedUs < freshUs) {
+            qint64 left = timeoutMs - timer.elapsed();
+            if (left <= 0 || !snapshotReady.wait(&snapshotLock, (unsigned long)left)) break;
+        }
+    }
+    if (snapshotImage.isNull()) return false;
+    *image = snapshotImage;
+    if (info) *info = snapshotInfo;
+    return true;
+}
+
+QSize cameraThread::frameSize() const
+{
+    QMutexLocker locker(&modeLock);
+    return publishedSize;
+}
+
+__u32 cameraThread::pixelFormat() const
+{
+    QMutexLocker locker(&modeLock);
+    return publishedFormat;
+}
+
+void cameraThread::publishMode()
+{
+    QMutexLocker locker(&modeLock);
+    publishedSize   = QSize(width, height);
+    publishedFormat = pixfmt;
+}
+
+bool cameraThread::hasStillMode() const
+{
+    return stillMode.width * stillMode.height > currentMode.width * currentMode.height;
+}
+
+void cameraThread::requestStill()
+{
+    stillRequested = true;
+    wakeup();
 }
 
 void cameraThread::startCapture()
 {
-    capturing = !capturing;
+    setCapturing(!capturing);
+}
+
+void cameraThread::setCapturing(bool on)
+{
+    if (capturing.exchange(on) == on) return;
+    wakeup();
+}
+
+void cameraThread::stop()
+{
+    requestInterruption();
+    wakeup();
+}
+
+void cameraThread::wakeup()
+{
+    uint64_t one = 1;
+    if (wakefd >= 0 && ::write(wakefd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
 }
 
 void cameraThread::run()
 {
-    while (true) {
-        if (capturing) {
-            if (readFrame() < 0) {
+    struct pollfd fds[2];
+    while (!isInterruptionRequested()) {
+        // 帧率变化时重新下发；UVC 等驱动要求停流后才能改
+        if (rateDirty.exchange(false)) applyFrameRate();
+        if (stillRequested.exchange(false)) captureStill();
+
+        // 流的开关只在采集线程里做，暂停时 STREAMOFF，不再产生中断和唤醒
+        bool want = capturing;
+        if (want && !streaming) {
+            if (startStreaming() < 0) {
+                qWarning() << "start streaming failed:" << strerror(errno);
+                capturing = false;
+            }
+        } else if (!want && streaming) {
+            stopCaptureInternal();
+        }
+
+        // 帧率由驱动按 VIDIOC_S_PARM 控制：设备有缓冲就绪时 poll 立即返回
+        fds[0].fd      = wakefd;
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd      = streaming ? videofd : -1;
+        fds[1].events  = POLLIN;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t cnt;
+            if (::read(wakefd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) {
+                perror("eventfd read");
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            if (readFrame() < 0 && errno != EAGAIN) {
                 perror("readFrame");
             }
+        } else if (fds[1].revents & (POLLERR | POLLHUP)) {
+            // 设备被拔出或驱动出错，停止采集等待下一次开始
+            qWarning() << "camera poll error, stop capture";
+            stopCaptureInternal();
+            capturing = false;
+            emit errorshow();
         }
-        // 控制约30fps
-        usleep(33000);
     }
+    if (streaming) stopCaptureInternal();
 }
 
 int cameraThread::openAndInitDevice()
 {
-    const char* devices[] = { DEV_NAME0, DEV_NAME1 };
-    for (int i = 0; i < 2; ++i) {
-        videofd = ::open(devices[i], O_RDWR);
+    // 指定了设备时只打开该设备，否则按默认列表回退
+    QList<QByteArray> devices;
+    if (!device.isEmpty()) devices << device.toLocal8Bit();
+    else                   devices << DEV_NAME0 << DEV_NAME1;
+    device.clear();
+
+    for (const QByteArray &path : devices) {
+        videofd = ::open(path.constData(), O_RDWR | O_NONBLOCK);
         if (videofd < 0) {
-            qWarning() << "open" << devices[i] << "failed:" << strerror(errno);
+            qWarning() << "open" << path << "failed:" << strerror(errno);
             continue;
         }
-        qDebug() << "open" << devices[i] << "success";
+        qDebug() << "open" << path << "success";
 
-        getVideoFmt();
         if (queryVideoCap() < 0 ||
-            setVideoFmt() < 0 ||
-            requestVideoBufsAndMmap() < 0)
+            enumVideoModes() < 0 ||
+            selectVideoMode() < 0 ||
+            requestVideoBufsAndMmap(requestDepth) < 0)
         {
+            // 释放本设备上已申请的缓冲，再换下一个设备
+            uninitVideo();
             closeVideo(videofd);
             videofd = -1;
             continue;
         }
+        // 不支持设置帧率的驱动仍可按默认帧率采集，不算失败
+        applyFrameRate();
+        publishMode();
+        device = QString::fromLocal8Bit(path);
         return 0;
     }
     return -1;
 }
 
-void cameraThread::getVideoFmt()
+int cameraThread::queryVideoCap()
+{
+    struct v4l2_capability cap;
+    if (ioctl(videofd, VIDIOC_QUERYCAP, &cap) < 0) return -1;
+    if (!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) return -1;
+    if (!(cap.capabilities & V4L2_CAP_STREAMING))     return -1;
+    return 0;
+}
+
+double VideoMode::maxFps() const
+{
+    double best = 0;
+    for (const v4l2_fract &iv : intervals) {
+        if (iv.numerator > 0) best = qMax(best, double(iv.denominator) / iv.numerator);
+    }
+    return best;
+}
+
+// 能转换的格式及其转换代价，数值越小越便宜；-1 表示不支持
+static int formatCost(__u32 pixelformat)
+{
+    switch (pixelformat) {
+    case V4L2_PIX_FMT_YUYV:  return 0;
+    case V4L2_PIX_FMT_NV12:  return 1;
+    case V4L2_PIX_FMT_MJPEG: return 2;
+    default:                 return -1;
+    }
+}
+
+int cameraThread::enumVideoModes()
 {
+    modes.clear();
+
     struct v4l2_fmtdesc fmt;
     CLEAR(fmt);
-    fmt.index = 0;
-    fmt.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    while (ioctl(videofd, VIDIOC_ENUM_FMT, &fmt) == 0) {
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for (fmt.index = 0; ioctl(videofd, VIDIOC_ENUM_FMT, &fmt) == 0; fmt.index++) {
         fprintf(stdout,
                 "fmt %u: %c%c%c%c (%s)\n",
                 fmt.index,
@@ -94,58 +350,371 @@ void cameraThread::getVideoFmt()
                 (fmt.pixelformat >> 16) & 0xFF,
                 (fmt.pixelformat >> 24) & 0xFF,
                 fmt.description);
-        fmt.index++;
+
+        struct v4l2_frmsizeenum fsize;
+        CLEAR(fsize);
+        fsize.pixel_format = fmt.pixelformat;
+        for (fsize.index = 0; ioctl(videofd, VIDIOC_ENUM_FRAMESIZES, &fsize) == 0; fsize.index++) {
+            if (fsize.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+                addVideoMode(fmt.pixelformat, fsize.discrete.width, fsize.discrete.height);
+                continue;
+            }
+            // STEPWISE/CONTINUOUS：取对齐到步长的请求尺寸和最大尺寸两个候选
+            const struct v4l2_frmsize_stepwise &sw = fsize.stepwise;
+            int stepW = qMax<int>(sw.step_width, 1);
+            int stepH = qMax<int>(sw.step_height, 1);
+            int w = qBound<int>(sw.min_width,  requestSize.width(),  sw.max_width);
+            int h = qBound<int>(sw.min_height, requestSize.height(), sw.max_height);
+            w = sw.min_width  + (w - sw.min_width)  / stepW * stepW;
+            h = sw.min_height + (h - sw.min_height) / stepH * stepH;
+            addVideoMode(fmt.pixelformat, w, h);
+            addVideoMode(fmt.pixelformat, sw.max_width, sw.max_height);
+            break;
+        }
+        // 不支持 ENUM_FRAMESIZES 的驱动：只能按请求尺寸尝试
+        if (fsize.index == 0) {
+            addVideoMode(fmt.pixelformat, requestSize.width(), requestSize.height());
+        }
     }
+    return modes.isEmpty() ? -1 : 0;
 }
 
-int cameraThread::queryVideoCap()
+void cameraThread::addVideoMode(__u32 pixelformat, int w, int h)
 {
-    struct v4l2_capability cap;
-    if (ioctl(videofd, VIDIOC_QUERYCAP, &cap) < 0) return -1;
-    if (!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) return -1;
-    if (!(cap.capabilities & V4L2_CAP_STREAMING))     return -1;
-    return 0;
+    VideoMode mode;
+    mode.pixelformat = pixelformat;
+    mode.width       = w;
+    mode.height      = h;
+
+    struct v4l2_frmivalenum ival;
+    CLEAR(ival);
+    ival.pixel_format = pixelformat;
+    ival.width        = w;
+    ival.height       = h;
+    for (ival.index = 0; ioctl(videofd, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0; ival.index++) {
+        if (ival.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
+            mode.intervals.append(ival.discrete);
+        } else {
+            // 连续/步进区间只记录两端
+            mode.intervals.append(ival.stepwise.min);
+            mode.intervals.append(ival.stepwise.max);
+            break;
+        }
+    }
+    fprintf(stdout, "  %dx%d up to %.1f fps\n", w, h, mode.maxFps());
+    modes.append(mode);
 }
 
-int cameraThread::setVideoFmt()
+bool cameraThread::betterMode(const VideoMode &a, const VideoMode &b) const
+{
+    // 1. 能达到帧率预算的优先；驱动不报告帧间隔时视为满足
+    double fpsA = a.maxFps(), fpsB = b.maxFps();
+    bool okA = fpsA <= 0 || fpsA + 0.5 >= requestFps;
+    bool okB = fpsB <= 0 || fpsB + 0.5 >= requestFps;
+    if (okA != okB) return okA;
+    if (!okA && fpsA != fpsB) return fpsA > fpsB;
+
+    // 2. 不超过请求分辨率的优先：都不超过取最大的，都超过取最接近的
+    bool inA = a.width <= requestSize.width() && a.height <= requestSize.height();
+    bool inB = b.width <= requestSize.width() && b.height <= requestSize.height();
+    if (inA != inB) return inA;
+    int areaA = a.width * a.height, areaB = b.width * b.height;
+    if (areaA != areaB) return inA ? areaA > areaB : areaA < areaB;
+
+    // 3. 同分辨率下转换代价低的格式优先，其次帧率高的
+    int costA = formatCost(a.pixelformat), costB = formatCost(b.pixelformat);
+    if (costA != costB) return costA < costB;
+    return fpsA > fpsB;
+}
+
+int cameraThread::selectVideoMode()
+{
+    const VideoMode *best = nullptr;
+    for (const VideoMode &mode : modes) {
+        if (formatCost(mode.pixelformat) < 0) continue;
+        if (!best || betterMode(mode, *best)) best = &mode;
+    }
+    if (!best) {
+        qWarning() << "no supported pixel format (YUYV/NV12/MJPEG)";
+        return -1;
+    }
+    currentMode = *best;
+    return setVideoFmt(*best);
+}
+
+void cameraThread::selectStillMode(const QSize &limit)
+{
+    // 不超过上限的最大分辨率；同分辨率优先 MJPEG，高分辨率下 USB 带宽和上传都省
+    stillMode = currentMode;
+    for (const VideoMode &mode : modes) {
+        int cost = formatCost(mode.pixelformat);
+        if (cost < 0 || mode.width > limit.width() || mode.height > limit.height()) continue;
+        int area = mode.width * mode.height, best = stillMode.width * stillMode.height;
+        if (area < best) continue;
+        if (area == best) {
+            bool jpeg = mode.pixelformat == V4L2_PIX_FMT_MJPEG;
+            bool bestJpeg = stillMode.pixelformat == V4L2_PIX_FMT_MJPEG;
+            if (jpeg != bestJpeg ? !jpeg : cost >= formatCost(stillMode.pixelformat)) continue;
+        }
+        stillMode = mode;
+    }
+    if (hasStillMode()) {
+        qDebug() << "still mode:" << stillMode.width << "x" << stillMode.height
+                 << QByteArray((const char*)&stillMode.pixelformat, 4);
+    }
+}
+
+int cameraThread::setVideoFmt(const VideoMode &mode)
 {
     struct v4l2_format fmt;
     CLEAR(fmt);
     fmt.type                = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    fmt.fmt.pix.width       = IMAGE_WIDTH;
-    fmt.fmt.pix.height      = IMAGE_HEIGHT;
-    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+    fmt.fmt.pix.width       = mode.width;
+    fmt.fmt.pix.height      = mode.height;
+    fmt.fmt.pix.pixelformat = mode.pixelformat;
     fmt.fmt.pix.field       = V4L2_FIELD_NONE;
     if (ioctl(videofd, VIDIOC_S_FMT, &fmt) < 0) return -1;
+
+    // 驱动可能调整尺寸与行宽，以返回值为准
+    width        = fmt.fmt.pix.width;
+    height       = fmt.fmt.pix.height;
+    pixfmt       = fmt.fmt.pix.pixelformat;
+    bytesPerLine = fmt.fmt.pix.bytesperline;
+    if (bytesPerLine == 0) {
+        bytesPerLine = (pixfmt == V4L2_PIX_FMT_YUYV) ? width * 2 : width;
+    }
+    imageSize = fmt.fmt.pix.sizeimage;
+    if (imageSize == 0) {
+        imageSize = (pixfmt == V4L2_PIX_FMT_NV12) ? bytesPerLine * height * 3 / 2
+                                                  : bytesPerLine * height;
+    }
+    qDebug() << "capture mode:" << width << "x" << height
+             << QByteArray((const char*)&pixfmt, 4) << "up to" << mode.maxFps() << "fps";
+    return 0;
+}
+
+int cameraThread::targetFrameRate() const
+{
+    int fps = 0;
+    for (int i = 0; i < RateConsumerCount; ++i) fps = qMax(fps, consumerRates[i].load());
+    return fps > 0 ? fps : requestFps;
+}
+
+int cameraThread::applyFrameRate()
+{
+    struct v4l2_streamparm parm;
+    CLEAR(parm);
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(videofd, VIDIOC_G_PARM, &parm) < 0 ||
+        !(parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        // 驱动不支持设置帧率，只能按传感器默认帧率采集
+        qDebug() << "driver has no frame-rate control";
+        return -1;
+    }
+
+    // 在当前模式支持的帧间隔中选满足需求的最低帧率，都不满足时取最快的；
+    // 驱动未报告帧间隔时直接请求 1/fps，由驱动取整
+    int want = targetFrameRate();
+    v4l2_fract tpf = { 1, (__u32)want };
+    double chosen = 0, fastest = 0;
+    v4l2_fract fastestTpf = tpf;
+    for (const v4l2_fract &iv : currentMode.intervals) {
+        if (iv.numerator == 0 || iv.denominator == 0) continue;
+        double fps = double(iv.denominator) / iv.numerator;
+        if (fps + 0.5 >= want && (chosen == 0 || fps < chosen)) {
+            chosen = fps;
+            tpf = iv;
+        }
+        if (fps > fastest) {
+            fastest = fps;
+            fastestTpf = iv;
+        }
+    }
+    if (chosen == 0 && fastest > 0) tpf = fastestTpf;
+
+    v4l2_fract old = parm.parm.capture.timeperframe;
+    if (currentFps > 0 && old.numerator == tpf.numerator && old.denominator == tpf.denominator) {
+        return 0;
+    }
+
+    bool wasStreaming = streaming;
+    if (wasStreaming) stopCaptureInternal();
+    parm.parm.capture.timeperframe = tpf;
+    int ret = ioctl(videofd, VIDIOC_S_PARM, &parm);
+    if (ret < 0) {
+        qWarning() << "VIDIOC_S_PARM failed:" << strerror(errno);
+    } else {
+        // 驱动返回实际采用的帧间隔
+        const v4l2_fract &act = parm.parm.capture.timeperframe;
+        currentFps = act.numerator ? double(act.denominator) / act.numerator : 0;
+        qDebug() << "frame rate:" << currentFps.load() << "fps (wanted" << want << ")";
+    }
+    if (wasStreaming && startStreaming() < 0) {
+        qWarning() << "restart streaming failed:" << strerror(errno);
+        capturing = false;
+    }
+    return ret < 0 ? -1 : 0;
+}
+
+int cameraThread::rgbStride() const
+{
+    // QImage 要求扫描行 4 字节对齐
+    return (width * 3 + 3) & ~3;
+}
+
+int cameraThread::requestVideoBufsAndMmap(int depth)
+{
+    if (memory == CaptureUserPtr) {
+        if (requestUserPtrBufs(depth) == 0) return 0;
+        // 不少驱动（如 dma-contig 的 CSI）不支持 USERPTR，回退到 MMAP
+        qWarning() << "USERPTR capture not supported, falling back to MMAP";
+        memory = CaptureMmap;
+    }
+    if (requestMmapBufs(depth) < 0) return -1;
+    if (memory == CaptureDmaBuf) exportDmaBufs();
+    qDebug() << "capture buffers:" << nbuffers
+             << (memory == CaptureDmaBuf ? "dmabuf" : "mmap");
     return 0;
 }
 
-int cameraThread::requestVideoBufsAndMmap()
+int cameraThread::requestMmapBufs(int depth)
 {
     struct v4l2_requestbuffers req;
     CLEAR(req);
-    req.count  = 4;
+    req.count  = depth;
     req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory = V4L2_MEMORY_MMAP;
     if (ioctl(videofd, VIDIOC_REQBUFS, &req) < 0) return -1;
+    // 驱动可能调整数量，以返回值为准；数量不够时也要把已分配的队列还给驱动
+    if (req.count < MIN_QUEUE_DEPTH) {
+        uninitVideo();
+        return -1;
+    }
 
     buffers = (buffer*)calloc(req.count, sizeof(buffer));
+    if (!buffers) {
+        uninitVideo();
+        return -1;
+    }
+    // nbuffers 始终是已映射的个数，出错时 uninitVideo 只解除这些映射
     for (nbuffers = 0; nbuffers < req.count; ++nbuffers) {
         struct v4l2_buffer buf;
         CLEAR(buf);
         buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         buf.memory = V4L2_MEMORY_MMAP;
         buf.index  = nbuffers;
-        if (ioctl(videofd, VIDIOC_QUERYBUF, &buf) < 0) return -1;
+        if (ioctl(videofd, VIDIOC_QUERYBUF, &buf) < 0) break;
+        void *start = mmap(nullptr, buf.length, PROT_READ|PROT_WRITE,
+                           MAP_SHARED, videofd, buf.m.offset);
+        if (start == MAP_FAILED) break;
+        buffers[nbuffers].dmafd  = -1;
         buffers[nbuffers].length = buf.length;
-        buffers[nbuffers].start = mmap(nullptr, buf.length,
-                                        PROT_READ|PROT_WRITE,
-                                        MAP_SHARED, videofd, buf.m.offset);
-        if (buffers[nbuffers].start == MAP_FAILED) return -1;
+        buffers[nbuffers].start  = start;
+    }
+    if (nbuffers < req.count) {
+        uninitVideo();
+        return -1;
+    }
+    return 0;
+}
+
+int cameraThread::requestUserPtrBufs(int depth)
+{
+    struct v4l2_requestbuffers req;
+    CLEAR(req);
+    req.count  = depth;
+    req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_USERPTR;
+    if (ioctl(videofd, VIDIOC_REQBUFS, &req) < 0) return -1;
+    if (req.count < MIN_QUEUE_DEPTH) {
+        uninitVideo();
+        return -1;
+    }
+
+    // 采集缓冲来自按页对齐的帧池：普通可缓存内存，转换内核读取比
+    // 驱动映射出的非缓存内存快得多
+    int pageSize = (int)sysconf(_SC_PAGESIZE);
+    int length   = (imageSize + pageSize - 1) & ~(pageSize - 1);
+    capturePool  = FramePool::create(req.count, length, pageSize);
+    buffers      = (buffer*)calloc(req.count, sizeof(buffer));
+    if (!capturePool || !buffers) {
+        uninitVideo();
+        return -1;
+    }
+    for (nbuffers = 0; nbuffers < req.count; ++nbuffers) {
+        unsigned char *start = capturePool->acquire();
+        if (!start) {
+            uninitVideo();
+            return -1;
+        }
+        buffers[nbuffers].dmafd  = -1;
+        buffers[nbuffers].length = length;
+        buffers[nbuffers].start  = start;
+    }
+    qDebug() << "capture buffers:" << nbuffers << "userptr," << length << "bytes each";
+    return 0;
+}
+
+void cameraThread::exportDmaBufs()
+{
+    for (unsigned int i = 0; i < nbuffers; ++i) {
+        struct v4l2_exportbuffer exp;
+        CLEAR(exp);
+        exp.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        exp.index = i;
+        exp.flags = O_RDONLY | O_CLOEXEC;
+        if (ioctl(videofd, VIDIOC_EXPBUF, &exp) < 0) {
+            qWarning() << "VIDIOC_EXPBUF failed:" << strerror(errno) << ", using plain MMAP";
+            // 已导出的全部关掉，其余路径都以 dmafd == -1 判断是否为 dmabuf
+            for (unsigned int j = 0; j < nbuffers; ++j) {
+                closeVideo(buffers[j].dmafd);
+                buffers[j].dmafd = -1;
+            }
+            memory = CaptureMmap;
+            return;
+        }
+        buffers[i].dmafd = exp.fd;
+    }
+}
+
+void cameraThread::syncDmaBuf(int fd, bool start)
+{
+    if (!dmaSync) return;
+    // CPU 读取导出的缓冲区前后需同步缓存；旧内核没有此 ioctl，缓存一致性由驱动的映射保证
+    struct dma_buf_sync sync;
+    CLEAR(sync);
+    sync.flags = (start ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) | DMA_BUF_SYNC_READ;
+    if (ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) {
+        perror("DMA_BUF_IOCTL_SYNC");
+        dmaSync = false;
+    }
+}
+
+static __u32 v4l2Memory(CaptureMemory memory)
+{
+    return memory == CaptureUserPtr ? V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP;
+}
+
+int cameraThread::startStreaming()
+{
+    if (videofd < 0 || nbuffers == 0 || !framePool) return -1;
+    // STREAMOFF 会把所有缓冲区退回用户态，每次开流前重新入队
+    for (unsigned int i = 0; i < nbuffers; ++i) {
+        struct v4l2_buffer buf;
+        CLEAR(buf);
+        buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = v4l2Memory(memory);
+        buf.index  = i;
+        if (memory == CaptureUserPtr) {
+            buf.m.userptr = (unsigned long)buffers[i].start;
+            buf.length    = buffers[i].length;
+        }
         if (ioctl(videofd, VIDIOC_QBUF, &buf) < 0) return -1;
     }
     int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     if (ioctl(videofd, VIDIOC_STREAMON, &type) < 0) return -1;
+    frameStats.streamStarted();
+    streaming = true;
     return 0;
 }
 
@@ -153,31 +722,431 @@ int cameraThread::readFrame()
 {
     CLEAR(tV4L2buf);
     tV4L2buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    tV4L2buf.memory = V4L2_MEMORY_MMAP;
+    tV4L2buf.memory = v4l2Memory(memory);
     if (ioctl(videofd, VIDIOC_DQBUF, &tV4L2buf) < 0) return -1;
-    storeImage();
+    // USERPTR 模式下 DQBUF 返回的 index/userptr/length 原样用于重新入队
+
+    updateFrameInfo();
+    quint64 captured = frameStats.frameDequeued(frameInfo, tV4L2buf.flags & V4L2_BUF_FLAG_ERROR);
+
+    // 先同步缓存再交给直连的消费者，CPU 读取（消费者与下面的转换）结束后再结束同步
+    int dmafd = buffers[tV4L2buf.index].dmafd;
+    if (dmafd >= 0) {
+        syncDmaBuf(dmafd, true);
+        emit dmabufReady(dmafd, tV4L2buf.bytesused);
+    }
+    qint64 t0 = monotonicUs();
+    if (storeImage() == 0) frameStats.frameConverted(monotonicUs() - t0);
+    if (dmafd >= 0) syncDmaBuf(dmafd, false);
     if (ioctl(videofd, VIDIOC_QBUF, &tV4L2buf) < 0) return -1;
+
+    // 约每 10 秒（30fps）输出一次统计，只在输出时才拷贝快照
+    if (captured % 300 == 0) qDebug() << "camera stats:" << frameStats.snapshot().summary();
     return 0;
 }
 
+void cameraThread::updateFrameInfo()
+{
+    // 驱动时间戳一般是 CLOCK_MONOTONIC；不是时只能以出队时刻代替
+    frameInfo.sequence   = tV4L2buf.sequence;
+    frameInfo.dequeuedUs = monotonicUs();
+    if ((tV4L2buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        frameInfo.timestampUs = (qint64)tV4L2buf.timestamp.tv_sec * 1000000
+                              + tV4L2buf.timestamp.tv_usec;
+    } else {
+        frameInfo.timestampUs = frameInfo.dequeuedUs;
+    }
+}
+
+void cameraThread::captureStill()
+{
+    RingFrame frame;
+    bool wasStreaming = streaming;
+    bool sameMode = stillMode.pixelformat == currentMode.pixelformat
+                 && stillMode.width == currentMode.width
+                 && stillMode.height == currentMode.height;
+    if (sameMode && wasStreaming) {
+        // 不必切换，下一帧顺带打包
+        stillNext = true;
+        return;
+    }
+
+    // 停流 -> 换格式、按最小队列深度重新申请缓冲 -> 取一帧 -> 恢复预览模式
+    qint64 t0 = monotonicUs();
+    if (wasStreaming) stopCaptureInternal();
+    bool ok = true;
+    if (!sameMode) {
+        uninitVideo();
+        ok = setVideoFmt(stillMode) == 0 && requestVideoBufsAndMmap(MIN_QUEUE_DEPTH) == 0;
+    }
+    if (ok && startStreaming() == 0) {
+        if (grabStill(&frame) < 0) qWarning() << "still capture failed:" << strerror(errno);
+    }
+    if (streaming) stopCaptureInternal();
+
+    if (!sameMode) {
+        uninitVideo();
+        if (setVideoFmt(currentMode) < 0 || requestVideoBufsAndMmap(requestDepth) < 0) {
+            qCritical() << "restore preview mode failed:" << strerror(errno);
+            capturing = false;
+            emit errorshow();
+        } else {
+            // S_FMT 可能把帧间隔重置为该模式的默认值
+            applyFrameRate();
+            publishMode();
+        }
+    }
+    if (wasStreaming && nbuffers > 0 && startStreaming() < 0) {
+        qWarning() << "restart streaming failed:" << strerror(errno);
+        capturing = false;
+    }
+    qDebug() << "still" << frame.width << "x" << frame.height
+             << "preview gap" << (monotonicUs() - t0) / 1000 << "ms";
+    emit stillReady(frame);
+}
+
+int cameraThread::grabStill(RingFrame *frame)
+{
+    struct pollfd pfd;
+    pfd.fd     = videofd;
+    pfd.events = POLLIN;
+    qint64 deadline = monotonicUs() + STILL_TIMEOUT_MS * 1000LL;
+    for (int n = 0; ; ++n) {
+        int left = (int)((deadline - monotonicUs()) / 1000);
+        if (left <= 0) {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        pfd.revents = 0;
+        int ret = ::poll(&pfd, 1, left);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) {
+            if (ret == 0) errno = ETIMEDOUT;
+            return -1;
+        }
+
+        CLEAR(tV4L2buf);
+        tV4L2buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        tV4L2buf.memory = v4l2Memory(memory);
+        if (ioctl(videofd, VIDIOC_DQBUF, &tV4L2buf) < 0) {
+            if (errno == EAGAIN) continue;
+            return -1;
+        }
+        // 刚开流的几帧曝光未稳定，出错的帧也不要
+        bool use = n >= STILL_SKIP_FRAMES && !(tV4L2buf.flags & V4L2_BUF_FLAG_ERROR);
+        if (use) {
+            updateFrameInfo();
+            int dmafd = buffers[tV4L2buf.index].dmafd;
+            if (dmafd >= 0) syncDmaBuf(dmafd, true);
+            packFrame((const unsigned char*)buffers[tV4L2buf.index].start, frame);
+            if (dmafd >= 0) syncDmaBuf(dmafd, false);
+        }
+        if (ioctl(videofd, VIDIOC_QBUF, &tV4L2buf) < 0) return -1;
+        if (use) return 0;
+    }
+}
+
+// UVC 摄像头的 MJPEG 帧通常省略 DHT 段，解码器要求的标准 Huffman 表
+// 取自 JPEG 规范附录 K.3（Tc/Th、16 个码长计数、码值）
+static const unsigned char kDcLumBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const unsigned char kDcLumVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+static const unsigned char kDcChrBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const unsigned char kDcChrVals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+static const unsigned char kAcLumBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static const unsigned char kAcLumVals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+static const unsigned char kAcChrBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const unsigned char kAcChrVals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static void appendHuffTable(QByteArray &seg, unsigned char tcth,
+                            const unsigned char *bits, const unsigned char *vals, int nvals)
+{
+    seg.append((char)tcth);
+    seg.append((const char*)bits, 16);
+    seg.append((const char*)vals, nvals);
+}
+
+static const QByteArray &defaultDhtSegment()
+{
+    static const QByteArray seg = [] {
+        QByteArray tables;
+        appendHuffTable(tables, 0x00, kDcLumBits, kDcLumVals, sizeof(kDcLumVals));
+        appendHuffTable(tables, 0x10, kAcLumBits, kAcLumVals, sizeof(kAcLumVals));
+        appendHuffTable(tables, 0x01, kDcChrBits, kDcChrVals, sizeof(kDcChrVals));
+        appendHuffTable(tables, 0x11, kAcChrBits, kAcChrVals, sizeof(kAcChrVals));
+        QByteArray dht("\xff\xc4", 2);
+        int len = tables.size() + 2;
+        dht.append((char)(len >> 8));
+        dht.append((char)(len & 0xff));
+        dht.append(tables);
+        return dht;
+    }();
+    return seg;
+}
+
+// 在扫描数据（SOS）之前找不到 DHT 段时，于 SOI 之后补上标准表
+static QByteArray mjpegWithHuffman(const unsigned char *data, int size)
+{
+    int pos = 2;
+    while (size >= 4 && pos + 4 <= size && data[pos] == 0xff) {
+        unsigned char marker = data[pos + 1];
+        if (marker == 0xc4) return QByteArray((const char*)data, size);
+        if (marker == 0xda) break;
+        pos += 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+    }
+    QByteArray out;
+    out.reserve(size + defaultDhtSegment().size());
+    out.append((const char*)data, qMin(size, 2));
+    out.append(defaultDhtSegment());
+    if (size > 2) out.append((const char*)data + 2, size - 2);
+    return out;
+}
+
+void cameraThread::packFrame(const unsigned char *src, RingFrame *frame)
+{
+    frame->info         = frameInfo;
+    frame->focus        = 0;
+    frame->pixelformat  = pixfmt;
+    frame->width        = width;
+    frame->height       = height;
+    frame->bytesPerLine = bytesPerLine;
+    if (pixfmt == V4L2_PIX_FMT_MJPEG) {
+        frame->data = mjpegWithHuffman(src, tV4L2buf.bytesused);
+    } else {
+        int size = qMin<int>(imageSize, buffers[tV4L2buf.index].length);
+        frame->data = QByteArray((const char*)src, size);
+    }
+}
+
 int cameraThread::storeImage()
 {
-    // YUYV -> RGB888
-    yuyv_to_rgb888((unsigned char*)buffers[tV4L2buf.index].start, rgbBuffer);
+    const unsigned char *src = (const unsigned char*)buffers[tV4L2buf.index].start;
+    if (stillNext) {
+        stillNext = false;
+        RingFrame frame;
+        packFrame(src, &frame);
+        emit stillReady(frame);
+    }
 
-    // 构造 QImage 并发射
-    QImage img(rgbBuffer,
-               IMAGE_WIDTH,
-               IMAGE_HEIGHT,
-               QImage::Format_RGB888);
-    emit imageReady(img);
+    // 预览每帧都做，但直接转换到预览尺寸；全分辨率转换只在有人请求时做
+    static const QMetaMethod previewSignal = QMetaMethod::fromSignal(&cameraThread::previewReady);
+    bool wantPreview = isSignalConnected(previewSignal);
+    bool wantFull    = fullFrameRequests.exchange(0) > 0;
+
+    if (pixfmt == V4L2_PIX_FMT_MJPEG) {
+        return storeMjpeg(src, tV4L2buf.bytesused, wantPreview, wantFull);
+    }
+    storeRing(src);
+    // 画面与上次送出的预览相比没有可见变化时，跳过转换，GUI 也不必重绘
+    bool changed = detectMotion(src);
+    if (changed) {
+        previewCurrent = false;
+    } else if (skipStillPreview && previewCurrent) {
+        frameStats.frameUnchanged();
+        wantPreview = false;
+    }
+    // 没有任何转换时返回 1，不计入转换耗时
+    if (!wantPreview && !wantFull) return 1;
+    int ret = 0;
+    if (wantPreview && storePreview(src) < 0) ret = -1;
+    if (wantFull && storeFullFrame(src) < 0) {
+        // 本帧没能生成，请求留到下一帧
+        fullFrameRequests++;
+        ret = -1;
+    }
+    return ret;
+}
+
+void cameraThread::storeRing(const unsigned char *src)
+{
+    if (!frameRing) return;
+    double focus = (pixfmt == V4L2_PIX_FMT_NV12)
+                 ? laplacianVariance(src, 1, bytesPerLine, width, height)
+                 : laplacianVariance(src, 2, bytesPerLine, width, height);
+    int size = qMin<int>(imageSize, buffers[tV4L2buf.index].length);
+    frameRing->addRaw(frameInfo, focus, src, size, pixfmt, width, height, bytesPerLine);
+}
+
+bool cameraThread::detectMotion(const unsigned char *src)
+{
+    bool changed = true;
+    int ystep = (pixfmt == V4L2_PIX_FMT_NV12) ? 1 : 2;
+    switch (motion.update(src, ystep, bytesPerLine, width, height, &changed)) {
+    case MotionDetector::SceneChanged:
+        qDebug() << "scene changed, diff" << motion.lastDifference();
+        emit sceneChanged(frameInfo);
+        break;
+    case MotionDetector::SceneStable:
+        qDebug() << "scene stable";
+        emit sceneStable(frameInfo);
+        break;
+    default:
+        break;
+    }
+    return changed;
+}
+
+QImage cameraThread::decodeJpeg(QByteArray &jpeg, const QSize &size)
+{
+    // JPEG 解码器按 DCT 缩放直接输出接近目标尺寸的图像
+    QBuffer buf(&jpeg);
+    QImageReader reader(&buf, "JPG");
+    reader.setScaledSize(size);
+    return reader.read();
+}
+
+int cameraThread::storeMjpeg(const unsigned char *src, int size, bool wantPreview, bool wantFull)
+{
+    // MJPEG：码流原样交给上传方，只有预览或全分辨率请求时才解码
+    static const QMetaMethod jpegSignal = QMetaMethod::fromSignal(&cameraThread::jpegReady);
+    bool wantJpeg = isSignalConnected(jpegSignal);
+    if (!wantJpeg && !wantPreview && !wantFull && !frameRing) return 0;
+
+    QByteArray jpeg = mjpegWithHuffman(src, size);
+    if (wantJpeg) emit jpegReady(jpeg, frameInfo);
+
+    QSize target = previewTarget();
+    QImage preview;
+    if (wantPreview && !target.isEmpty()) preview = decodeJpeg(jpeg, target);
+    if (frameRing) {
+        // 评分直接用预览解码的结果，不为此再解码一遍；没有预览时只在本帧所在格
+        // 还空着（任何评分都会收下）时才单独解码，每个窗口最多 RING_BUCKETS 次。
+        // 评分尺寸与预览一致，同一格里的分数才可比；解码失败的坏帧不进帧环
+        QImage scored = preview;
+        if (scored.isNull() && frameRing->bucketEmpty(frameInfo)) {
+            if (target.isEmpty()) target = QSize(width, height) / RING_JPEG_FOCUS_SCALE;
+            scored = decodeJpeg(jpeg, target);
+        }
+        if (!scored.isNull()) {
+            frameRing->addJpeg(frameInfo, imageFocus(scored, &focusLuma), jpeg, width, height);
+        }
+    }
+
+    if (!preview.isNull()) emit previewReady(preview, frameInfo);
+    if (wantFull) {
+        QImage img;
+        if (!img.loadFromData(jpeg, "JPG")) {
+            fullFrameRequests++;
+            return -1;
+        }
+        deliverFullFrame(img);
+    }
+    return 0;
+}
+
+QSize cameraThread::previewTarget()
+{
+    QMutexLocker locker(&previewLock);
+    if (previewSize.isEmpty()) return QSize();
+    // 保持宽高比放进预览区域，不做放大
+    QSize frame(width, height);
+    return frame.scaled(previewSize.boundedTo(frame), Qt::KeepAspectRatio);
+}
+
+int cameraThread::storePreview(const unsigned char *src)
+{
+    QSize target = previewTarget();
+    if (target.isEmpty()) return 0;
+
+    int stride = target.width() * 4;
+    int bytes  = stride * target.height();
+    if (!previewPool || previewPool->slotBytes() < bytes) {
+        // 预览区域变大时换一个更大的池，旧池在其帧全部归还后自行释放
+        if (previewPool) previewPool->release();
+        previewPool = FramePool::create(PREVIEW_POOL_SLOTS, bytes);
+        if (!previewPool) return -1;
+    }
+    unsigned char *dst = previewPool->acquire();
+    if (!dst) {
+        frameStats.frameDropped();
+        return -1;
+    }
+
+    // 转换和缩小一次完成，输出可直接显示的 RGB32
+    if (pixfmt == V4L2_PIX_FMT_NV12) {
+        nv12_to_rgb32_scaled(src, bytesPerLine,
+                             src + bytesPerLine * height, bytesPerLine,
+                             width, height,
+                             dst, stride, target.width(), target.height());
+    } else {
+        yuyv_to_rgb32_scaled(src, bytesPerLine, width, height,
+                             dst, stride, target.width(), target.height());
+    }
+    QImage img = previewPool->wrap(dst, target.width(), target.height(), stride,
+                                   QImage::Format_RGB32);
+    emit previewReady(img, frameInfo);
+    previewCurrent = true;
+    return 0;
+}
+
+int cameraThread::storeFullFrame(const unsigned char *src)
+{
+    // 每帧转换到独立的池槽，消费者仍在读的帧不会被覆盖
+    unsigned char *rgb = framePool->acquire();
+    if (!rgb) {
+        // 消费者来不及处理，丢帧而不是无限排队
+        frameStats.frameDropped();
+        return -1;
+    }
+
+    // 按 CPU 选择的向量内核转换到 RGB888
+    if (pixfmt == V4L2_PIX_FMT_NV12) {
+        nv12_to_rgb888(src, bytesPerLine,
+                       src + bytesPerLine * height, bytesPerLine,
+                       rgb, rgbStride(), width, height);
+    } else {
+        yuyv_to_rgb888(src, bytesPerLine, rgb, rgbStride(), width, height);
+    }
+
+    // QImage 持有池槽，最后一个副本析构时自动归还
+    deliverFullFrame(framePool->wrap(rgb, width, height, rgbStride(),
+                                     QImage::Format_RGB888));
     return 0;
 }
 
+void cameraThread::deliverFullFrame(const QImage &img)
+{
+    emit imageReady(img, frameInfo);
+    publishSnapshot(img);
+}
+
+void cameraThread::publishSnapshot(const QImage &img)
+{
+    // 留给 snapshot()：只存全分辨率帧，只增加引用计数，占住一个池槽直到被下一帧替换
+    QMutexLocker locker(&snapshotLock);
+    snapshotImage = img;
+    snapshotInfo  = frameInfo;
+    snapshotReady.wakeAll();
+}
+
 int cameraThread::stopCaptureInternal()
 {
     int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     ioctl(videofd, VIDIOC_STREAMOFF, &type);
+    streaming = false;
     return 0;
 }
 
@@ -189,35 +1158,24 @@ void cameraThread::closeVideo(int fd)
 int cameraThread::uninitVideo()
 {
     for (unsigned int i = 0; i < nbuffers; ++i) {
-        munmap(buffers[i].start, buffers[i].length);
+        closeVideo(buffers[i].dmafd);
+        if (capturePool) capturePool->recycle((unsigned char*)buffers[i].start);
+        else             munmap(buffers[i].start, buffers[i].length);
     }
-    return 0;
-}
-
-int cameraThread::yuyv_to_rgb888(const unsigned char *yuyv, unsigned char *rgb)
-{
-    int idx = 0;
-    for (int i = 0; i < IMAGE_HEIGHT; ++i) {
-        for (int j = 0; j < IMAGE_WIDTH; j += 2) {
-            int y0 = *yuyv++ - 16;
-            int u  = *yuyv++ - 128;
-            int y1 = *yuyv++ - 16;
-            int v  = *yuyv++ - 128;
-            int c0 = (298*y0 + 128) >> 8;
-            int c1 = (298*y1 + 128) >> 8;
-            int r0 = c0 + ((409 * v) >> 8);
-            int g0 = c0 - ((100 * u + 208 * v) >> 8);
-            int b0 = c0 + ((516 * u) >> 8);
-            int r1 = c1 + ((409 * v) >> 8);
-            int g1 = c1 - ((100 * u + 208 * v) >> 8);
-            int b1 = c1 + ((516 * u) >> 8);
-            rgb[idx++] = qBound(0, r0, 255);
-            rgb[idx++] = qBound(0, g0, 255);
-            rgb[idx++] = qBound(0, b0, 255);
-            rgb[idx++] = qBound(0, r1, 255);
-            rgb[idx++] = qBound(0, g1, 255);
-            rgb[idx++] = qBound(0, b1, 255);
-        }
+    nbuffers = 0;
+    free(buffers);
+    buffers = nullptr;
+    // 让驱动放下对用户内存的引用后再释放
+    if (videofd >= 0) {
+        struct v4l2_requestbuffers req;
+        CLEAR(req);
+        req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = v4l2Memory(memory);
+        ioctl(videofd, VIDIOC_REQBUFS, &req);
+    }
+    if (capturePool) {
+        capturePool->release();
+        capturePool = nullptr;
     }
     return 0;
 }
@@ -3,6 +3,11 @@
 
 #include <QThread>
 #include <QImage>
+#include <QSize>
+#include <QVector>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
 #include <linux/videodev2.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -12,19 +17,84 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <atomic>
+#include "framepool.h"
+#include "framestats.h"
+#include "framering.h"
+#include "motiondetector.h"
 
 // 设备名
 #define DEV_NAME0 "/dev/video2"
 #define DEV_NAME1 "/dev/video3"
 
-#define IMAGE_WIDTH  640
-#define IMAGE_HEIGHT 480
+// 默认请求的采集模式，实际模式在打开设备时与驱动协商
+#define DEFAULT_WIDTH  640
+#define DEFAULT_HEIGHT 480
+#define DEFAULT_FPS    30
+// 驱动缓冲队列深度：越深越不容易在负载尖峰时丢帧，但延迟与内存随之增加
+#define DEFAULT_QUEUE_DEPTH 4
+#define MIN_QUEUE_DEPTH     2
+// 触发前帧环：默认保留最近 2 秒，分 8 格各留最清晰的一帧
+#define DEFAULT_RING_MS 2000
+#define RING_BUCKETS    8
+// MJPEG 帧的清晰度评分借用预览解码的结果；没有预览尺寸时按 1/N 尺寸（DCT 缩放）解码
+#define RING_JPEG_FOCUS_SCALE 2
+// 帧池槽数：全分辨率帧只在按需请求时生成；预览帧每帧一张，GUI 持有一张，其余排队
+#define FRAME_POOL_SLOTS   3
+#define PREVIEW_POOL_SLOTS 6
+// 高分辨率静帧：切换格式后丢掉的前几帧（自动曝光尚未收敛），以及等待出帧的上限
+#define STILL_SKIP_FRAMES 2
+#define STILL_TIMEOUT_MS  2000
+// snapshot() 等待新全分辨率帧的默认时间，足够低帧率下等到下一帧；
+// 采集中已有的全分辨率帧不超过 SNAPSHOT_MAX_AGE_MS 时直接返回
+#define SNAPSHOT_TIMEOUT_MS 1000
+#define SNAPSHOT_MAX_AGE_MS 200
 #define CLEAR(x) memset(&(x), 0, sizeof(x))
 
 // V4L2 缓冲区描述
 struct buffer {
     void   *start;
     size_t  length;
+    int     dmafd;      // CaptureDmaBuf 模式下导出的 dmabuf，否则为 -1
+};
+
+// 采集缓冲区的内存方式
+enum CaptureMemory {
+    CaptureMmap,        // 驱动分配，mmap 到用户态（默认）
+    CaptureUserPtr,     // 驱动直接写入帧池分配的可缓存内存
+    CaptureDmaBuf       // 驱动分配并导出 dmabuf fd，供下游设备零拷贝导入
+};
+
+// 帧率需求方：驱动帧率取各方需求的最大值
+enum RateConsumer {
+    RatePreview,        // 界面预览
+    RateRecognition,    // 帧环/运动检测/识别
+    RateRecording,      // 录像（预留）
+    RateConsumerCount
+};
+
+// 采集配置；构造后不可更改
+struct CaptureConfig {
+    QString        device;      // 为空时依次尝试 DEV_NAME0、DEV_NAME1
+    QSize          size       = QSize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    int            fps        = DEFAULT_FPS;
+    CaptureMemory  memory     = CaptureMmap;
+    int            queueDepth = DEFAULT_QUEUE_DEPTH;
+    int            ringMs     = DEFAULT_RING_MS;   // 0 关闭帧环
+    QSize          stillSize;   // 静帧分辨率上限，为空时静帧与预览同一模式
+
+    // 读取环境变量 CAMERA_IO（mmap/userptr/dmabuf）、CAMERA_BUFFERS、CAMERA_STILL（如 1920x1080）覆盖默认值
+    static CaptureConfig fromEnvironment();
+};
+
+// 设备支持的一种采集模式：像素格式 + 分辨率 + 可选帧间隔
+struct VideoMode {
+    __u32                 pixelformat = 0;
+    int                   width  = 0;
+    int                   height = 0;
+    QVector<v4l2_fract>   intervals;       // 每帧时间，越小帧率越高
+
+    double maxFps() const;
 };
 
 class cameraThread : public QThread
@@ -33,18 +103,78 @@ class cameraThread : public QThread
 
 public:
     explicit cameraThread(QObject *parent = nullptr);
+    // 按请求的分辨率/帧率预算挑选最合适的模式
+    cameraThread(const QSize &size, int fps, QObject *parent = nullptr);
+    explicit cameraThread(const CaptureConfig &config, QObject *parent = nullptr);
     ~cameraThread() override;
 
+    // 实际打开的设备，打开失败时为空
+    QString devicePath() const { return device; }
+    // 协商后的预览分辨率与像素格式，任意线程可调用；静帧切换格式期间仍返回预览模式
+    QSize frameSize() const;
+    __u32 pixelFormat() const;
+    // 实际使用的内存方式与队列深度（驱动不支持时会回退到 MMAP / 调整数量）
+    CaptureMemory captureMemory() const { return memory; }
+    int queueDepth() const { return (int)nbuffers; }
+    // 声明某一方需要的帧率，0 表示不需要；驱动按各方最大值运行，
+    // 都未声明时按构造时请求的帧率。可在任意线程调用，由采集线程下发 VIDIOC_S_PARM
+    void setConsumerRate(RateConsumer consumer, int fps);
+    // 驱动当前实际帧率（驱动不支持设置时为 0）
+    double frameRate() const { return currentFps; }
+
+    // 场景无变化时不再重新生成预览帧（默认开启）；需要稳定帧率的消费者（如双摄配对）应关闭
+    void setSkipStillPreview(bool skip);
+    // 帧环中距现在 ringMs 内最清晰的一帧，可在任意线程调用；暂停采集超过 ringMs 后返回 false
+    bool sharpestRecentFrame(RingFrame *frame);
+    // 采集统计（丢帧、转换耗时、显示延迟），消费者显示帧后调用 frameDisplayed 记录延迟
+    FrameStats *stats() { return &frameStats; }
+
+    // 预览区域尺寸：预览帧按此尺寸（保持比例、不放大）直接转换生成
+    void setPreviewSize(const QSize &size);
+    // 请求下一帧的全分辨率 RGB888 图像，通过 imageReady 返回一次
+    void requestFullFrame();
+    // 最近送出的全分辨率帧，与 imageReady 共享同一池槽（只增加引用计数）；预览帧不算。
+    // 采集中没有或只有过时（超过 SNAPSHOT_MAX_AGE_MS）的全分辨率帧时请求一帧并等待，
+    // 超时仍返回已有的旧帧；暂停采集后直接返回暂停前的最后一帧。没有任何帧时返回 false。
+    // 不可在采集线程调用，其它任意线程可调用
+    bool snapshot(QImage *image, FrameInfo *info = nullptr,
+                  int timeoutMs = SNAPSHOT_TIMEOUT_MS);
+    // 设备有比预览更大的静帧模式
+    bool hasStillMode() const;
+    // 请求一张静帧，通过 stillReady 返回一次：静帧模式与预览不同时，采集线程
+    // 短暂切换格式取一帧后恢复预览；暂停采集时同样可用
+    void requestStill();
+
     // 切换开始/停止采集
     void startCapture();
+    // 明确开始或停止采集，可在任意线程调用
+    void setCapturing(bool on);
+    bool isCapturing() const { return capturing; }
+    // 请求线程退出并唤醒阻塞中的 poll
+    void stop();
 
 signals:
-    // 返回每帧图像
-    void imageReady(const QImage &img);
+    // 预览尺寸的 RGB32 图像，每帧一张
+    void previewReady(const QImage &img, const FrameInfo &info);
+    // 全分辨率 RGB888 图像，仅在 requestFullFrame() 之后返回
+    void imageReady(const QImage &img, const FrameInfo &info);
+    // MJPEG 模式下每帧的原始压缩码流（已补全 Huffman 表），可直接上传
+    void jpegReady(const QByteArray &jpeg, const FrameInfo &info);
+    // CaptureDmaBuf 模式下每帧在采集线程内同步发出；槽返回后缓冲区即重新入队，
+    // 只能以 Qt::DirectConnection 连接，需要保留内容的消费者应在槽内完成导入/拷贝
+    void dmabufReady(int fd, int bytesused);
+    // Y 分量帧差检测：场景开始变化 / 变化后重新静止（MJPEG 模式下不检测）
+    void sceneChanged(const FrameInfo &info);
+    void sceneStable(const FrameInfo &info);
+    // requestStill() 的结果，原始数据或 MJPEG 码流；失败时为空帧
+    void stillReady(const RingFrame &frame);
     // 初始化失败
     void errorshow();
 
 protected:
+    // 单元测试用假的缓冲区直接驱动 storeImage()，不需要摄像头
+    friend class TestGeoProspector;
+
     // 线程主循环
     void run() override;
 
@@ -52,28 +182,95 @@ private:
     // V4L2 初始化步骤
     int  openAndInitDevice();
     int  queryVideoCap();
-    int  setVideoFmt();
-    int  requestVideoBufsAndMmap();
+    int  enumVideoModes();
+    int  selectVideoMode();
+    void selectStillMode(const QSize &limit);
+    void addVideoMode(__u32 pixelformat, int w, int h);
+    bool betterMode(const VideoMode &a, const VideoMode &b) const;
+    int  setVideoFmt(const VideoMode &mode);
+    void publishMode();
+    int  applyFrameRate();
+    int  targetFrameRate() const;
+    int  requestVideoBufsAndMmap(int depth);
+    int  requestMmapBufs(int depth);
+    int  requestUserPtrBufs(int depth);
+    void exportDmaBufs();
+    void syncDmaBuf(int fd, bool start);
 
     // 采集与释放
+    int  startStreaming();
     int  readFrame();
+    void updateFrameInfo();
+    void packFrame(const unsigned char *src, RingFrame *frame);
+    void captureStill();
+    int  grabStill(RingFrame *frame);
     int  storeImage();
+    void storeRing(const unsigned char *src);
+    bool detectMotion(const unsigned char *src);
+    QImage decodeJpeg(QByteArray &jpeg, const QSize &size);
+    int  storeMjpeg(const unsigned char *src, int size, bool wantPreview, bool wantFull);
+    int  storePreview(const unsigned char *src);
+    int  storeFullFrame(const unsigned char *src);
+    void deliverFullFrame(const QImage &img);
+    void publishSnapshot(const QImage &img);
+    QSize previewTarget();
     int  stopCaptureInternal();
     int  uninitVideo();
 
-    // 格式转换
-    int  yuyv_to_rgb888(const unsigned char *yuyv, unsigned char *rgb);
-
     // V4L2 辅助
-    void getVideoFmt();
     void closeVideo(int fd);
+    void wakeup();
+    int  rgbStride() const;
 
     // 成员变量
     int                videofd = -1;
-    bool               capturing = false;
+    int                wakefd = -1;        // eventfd，用于唤醒 poll
+    std::atomic<bool>  capturing{false};   // GUI 线程写，采集线程读
+    bool               streaming = false;  // 仅采集线程访问
     struct buffer     *buffers = nullptr;
     unsigned int       nbuffers = 0;
-    unsigned char     *rgbBuffer = nullptr;
+    FramePool         *framePool = nullptr;
+    FramePool         *capturePool = nullptr;  // CaptureUserPtr 模式下的采集缓冲
+    bool               dmaSync = true;         // 内核支持 DMA_BUF_IOCTL_SYNC
+    FramePool         *previewPool = nullptr;
+    FrameStats         frameStats;
+    FrameRing         *frameRing = nullptr;
+    QVector<unsigned char> focusLuma;      // MJPEG 评分用的亮度暂存，仅采集线程访问
+    MotionDetector     motion;
+    std::atomic<bool>  skipStillPreview{true};
+    std::atomic<bool>  previewCurrent{false};  // GUI 已有与当前场景一致的预览帧
+    FrameInfo          frameInfo;          // 当前出队帧的序号与时间戳
+    std::atomic<int>   fullFrameRequests{0};
+    QMutex             snapshotLock;
+    QWaitCondition     snapshotReady;
+    QImage             snapshotImage;          // 最近的全分辨率帧，以下受 snapshotLock 保护
+    FrameInfo          snapshotInfo;
+    std::atomic<bool>  stillRequested{false};
+    bool               stillNext = false;  // 静帧与预览同模式时，下一帧即为静帧
+    QMutex             previewLock;
+    QSize              previewSize;        // 受 previewLock 保护
+
+    // 请求与协商结果
+    QString            device;
+    QSize              requestSize;
+    int                requestFps = DEFAULT_FPS;
+    CaptureMemory      memory = CaptureMmap;
+    int                requestDepth = DEFAULT_QUEUE_DEPTH;
+    QVector<VideoMode> modes;              // 设备支持的全部模式
+    VideoMode          currentMode;
+    VideoMode          stillMode;          // 打开设备后确定，之后只读
+    std::atomic<int>   consumerRates[RateConsumerCount];
+    std::atomic<bool>  rateDirty{false};
+    std::atomic<double> currentFps{0};
+    int                width = 0;
+    int                height = 0;
+    __u32              pixfmt = 0;
+    int                bytesPerLine = 0;
+    int                imageSize = 0;      // 驱动给出的单帧字节数
+    // 以上只由采集线程访问；对外公布的预览模式另存一份，设好预览模式后才更新
+    mutable QMutex     modeLock;
+    QSize              publishedSize;      // 受 modeLock 保护
+    __u32              publishedFormat = 0;
 
     // 缺少的 V4L2 缓冲区存储结构
     struct v4l2_buffer tV4L2buf;
@@ -1,130 +1,181 @@
 #include "dataprocess.h"
+#include "sensorhandle.h"
+#include "dht11reader.h"
+#include "monotonic.h"
+#include "iiosensor.h"
 #include <unistd.h>
 #include <QString>
 #include <QDebug>
 #include <sys/ioctl.h>
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
+#include <errno.h>
+#include <string.h>
+#include <atomic>
 
-int DataProcess(ProcessMode mode)
+// BH1750：ADDR 接地时地址 0x23；连续高分辨率模式下每次转换最长 180ms
+#define BH1750_ADDR          0x23
+#define BH1750_POWER_ON      0x01
+#define BH1750_CONT_HRES     0x10
+#define BH1750_CONVERSION_MS 180
+
+// 照度采集状态：I2C 打开时的配置和两种后端的读取都可能更新，一律原子访问
+static std::atomic<qint64> bh1750NextUs{0};     // 下一个新转换结果就绪的时刻
+static std::atomic<int>    bh1750Lux{-1};       // 最近一次有效照度，-1 表示还没有
+// 内核 IIO 驱动注册的设备名
+#define BH1750_IIO_NAME "bh1750"
+static std::atomic<int> lightBackendSetting{-1};   // -1 表示尚未读取环境变量
+
+// 地址放在消息里，不需要 I2C_SLAVE；一次 I2C_RDWR ioctl 完成整个传输
+static void bh1750Message(struct i2c_msg *msg, struct i2c_rdwr_ioctl_data *data,
+                          unsigned short flags, unsigned char *buf, unsigned short len)
 {
-    const char *path = nullptr;
-    switch (mode) {
-    case BroadGas:
-        path = "/dev/MQ2";
-        break;
-    case Ultrasonic:
-        path = "/dev/HCSR04";
-        break;
-    case LightLevel:
-        path = "/dev/i2c-0";
-        break;
-    case TempHumidity:
-        path = "/dev/DHT11";
-        break;
-    default:
-        qWarning() << "Unknown ProcessMode in DataProcess:" << mode;
-        return 0;
+    msg->addr   = BH1750_ADDR;
+    msg->flags  = flags;
+    msg->len    = len;
+    msg->buf    = buf;
+    data->msgs  = msg;
+    data->nmsgs = 1;
+}
+
+static int bh1750Command(int fd, unsigned char cmd)
+{
+    struct i2c_msg msg;
+    struct i2c_rdwr_ioctl_data data;
+    bh1750Message(&msg, &data, 0, &cmd, 1);
+    return ioctl(fd, I2C_RDWR, &data);
+}
+
+static int setupBh1750(int fd)
+{
+    // 上电并切到连续高分辨率模式，只在打开设备时做一次，之后传感器自己持续转换
+    if (bh1750Command(fd, BH1750_POWER_ON) < 0) {
+        qWarning() << "Failed to power on BH1750:" << strerror(errno);
+        return -1;
+    }
+    if (bh1750Command(fd, BH1750_CONT_HRES) < 0) {
+        qWarning() << "Failed to set BH1750 continuous mode:" << strerror(errno);
+        return -1;
     }
+    bh1750NextUs = monotonicUs() + BH1750_CONVERSION_MS * 1000LL;
+    return 0;
+}
+
+// 各传感器的常驻句柄，第一次采样时打开；每种模式只由一个采样线程使用
+static SensorHandle gasDevice("/dev/MQ2");
+static SensorHandle sonarDevice("/dev/HCSR04");
+static SensorHandle lightDevice("/dev/i2c-0", O_RDWR, setupBh1750);
 
-    int fd = ::open(path, O_RDWR);
-    if (fd < 0) {
-        qWarning() << "Failed to open device" << path;
-        return 0;
+// 失败返回 -1，不把旧值当作新读数
+static int readLightI2c()
+{
+    if (lightDevice.fd() < 0) return -1;
+    // 新的转换结果还没出来时直接返回上一次的有效值，不睡眠也不访问总线
+    qint64 now = monotonicUs();
+    if (now < bh1750NextUs) return bh1750Lux;
+    unsigned char buf[2];
+    struct i2c_msg msg;
+    struct i2c_rdwr_ioctl_data data;
+    bh1750Message(&msg, &data, I2C_M_RD, buf, 2);
+    if (lightDevice.ioctl(I2C_RDWR, (unsigned long)&data) < 0) {
+        qWarning() << "Failed to read from BH1750:" << strerror(errno);
+        return -1;
     }
+    int lux = static_cast<int>(((buf[0] << 8) | buf[1]) / 1.2f);
+    bh1750NextUs = now + BH1750_CONVERSION_MS * 1000LL;
+    bh1750Lux    = lux;
+    return lux;
+}
 
+static LightBackend lightBackend()
+{
+    int backend = lightBackendSetting;
+    if (backend < 0) {
+        backend = (qgetenv("LIGHT_BACKEND").toLower() == "iio") ? LightIio : LightI2c;
+        lightBackendSetting = backend;
+    }
+    return (LightBackend)backend;
+}
+
+void setLightBackend(LightBackend backend)
+{
+    lightBackendSetting = backend;
+}
+
+static int readLightIio()
+{
+    static IioSensor sensor(BH1750_IIO_NAME, "illuminance");
+    static QVector<IioSample> samples;
+    static bool fallback = false;
+    if (!sensor.isOpen() && !sensor.open()) {
+        // 内核里没有 bh1750 驱动时暂用 I2C 读数；IioSensor 自己按退避间隔重试，
+        // 驱动加载后自动切回 IIO
+        if (!fallback) qWarning() << "IIO light sensor unavailable, falling back to I2C";
+        fallback = true;
+        return readLightI2c();
+    }
+    if (fallback) {
+        qDebug() << "IIO light sensor available again";
+        fallback = false;
+        // 两条路径不能同时占着传感器
+        lightDevice.reset();
+    }
+    // resize(0) 保留容量，稳定后不再分配
+    samples.resize(0);
+    int n = sensor.read(&samples);
+    if (n < 0) {
+        qWarning() << "Failed to read IIO light sensor:" << strerror(errno);
+        sensor.close();
+        return -1;
+    }
+    // 缓冲模式下一次可能取回多个样本，这里只要最新值；没有新样本时沿用上一次的有效值
+    if (n == 0) return bh1750Lux;
+    int lux = static_cast<int>(samples.last().value);
+    bh1750Lux = lux;
+    return lux;
+}
+
+long long UltrasonicEcho()
+{
+    long long raw = 0;
+    if (sonarDevice.read(&raw, sizeof(raw)) != sizeof(raw)) return -1;
+    return raw;
+}
+
+int DataProcess(ProcessMode mode)
+{
     int result = 0;
     switch (mode) {
     case BroadGas: {
-        if (::read(fd, &result, sizeof(result)) != sizeof(result)) {
-
+        if (gasDevice.read(&result, sizeof(result)) != sizeof(result)) {
+            result = 0;
         }
         break;
     }
     case Ultrasonic: {
-        long long raw = 0;
-        if (::read(fd, &raw, sizeof(raw)) != sizeof(raw)) {
-
-        } else {
+        long long raw = UltrasonicEcho();
+        if (raw >= 0) {
             float dist = raw * 0.017f;
             result = static_cast<int>(dist * 100);
         }
         break;
     }
     case LightLevel: {
-        int addr = 0x23;
-        if (ioctl(fd, I2C_SLAVE, addr) < 0) {
-            qWarning() << "Failed to set I2C_SLAVE address to 0x23";
-            ::close(fd);
-            return 0;
-        }
-        unsigned char cmd = 0x10;
-        if (write(fd, &cmd, 1) != 1) {
-            qWarning() << "Failed to write measurement command to BH1750";
-            ::close(fd);
-            return 0;
-        }
-        usleep(1800);
-        unsigned char buf[2];
-        if (read(fd, buf, 2) != 2) {
-            qWarning() << "Failed to read from BH1750";
-            ::close(fd);
-            return 0;
-        }
-        float lux = ((buf[0] << 8) | buf[1]) / 1.2f;
-        result = static_cast<int>(lux);
+        result = (lightBackend() == LightIio) ? readLightIio() : readLightI2c();
         break;
     }
     case TempHumidity: {
-        if (mode != TempHumidity) return 0;
-
-         int fd = open("/dev/DHT11", O_RDONLY);
-         if (fd < 0) {
-             qDebug() << "open /dev/DHT11 failed:" << strerror(errno);
-             return 0;
-         }
-
-         unsigned char buf[6];
-         ssize_t n = read(fd, buf, sizeof(buf));
-         close(fd);
-
-         qDebug() << "DHT11 read n =" << n
-                  << "buf =" << QByteArray((char*)buf, n).toHex()
-                  << "sum =" << (buf[0]+buf[1]+buf[2]+buf[3]) << "chk" << buf[4];
-
-         if (n != 6) return 0;
-         uint8_t sum = buf[0] + buf[1] + buf[2] + buf[3];
-         if (buf[4] != sum) return 0;
-
-         int temp = buf[2];
-         int hum  = buf[0];
-         return (temp << 16) | hum;   // 高 16 位温度，低 16 位湿度
-        }
+        // 与其它消费者共用同一个读取器，不会让传感器测量过密
+        Dht11Reading reading;
+        if (!Dht11Reader::instance().update(&reading)) return 0;
+        // 保留驱动给出的一位小数
+        int temp = qRound(reading.temperature * 10);
+        int hum  = qRound(reading.humidity * 10);
+        return (temp << 16) | hum;   // 高 16 位温度，低 16 位湿度，均为 0.1 单位
+    }
     default:
+        qWarning() << "Unknown ProcessMode in DataProcess:" << mode;
         break;
     }
-    ::close(fd);
     return result;
 }
-
-void WarningGas(int gas)
-{
-    const char *LEDBUZZER_DEV = "/dev/LEDBuzzer";
-    const int GAS_THRESHOLD = 0;
-    int fd = ::open(LEDBUZZER_DEV, O_RDWR);
-    if (fd < 0) {
-        qWarning() << "WarningGas: failed to open" << LEDBUZZER_DEV;
-        return;
-    }
-    uint8_t cmd = (gas > GAS_THRESHOLD) ? 1 : 0;
-    if(cmd)
-    {
-        ioctl(fd,2);
-        ioctl(fd,4);
-
-    }
-    else{
-        ioctl(fd,3);
-        ioctl(fd,1);
-    }
-    ::close(fd);
-}
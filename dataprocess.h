@@ -13,14 +13,27 @@ enum ProcessMode {
     TempHumidity,
     LEDBuzzer
 };
-//用来加载设备驱动，并打开/dev/*
-//获取数据并显示在相应的qlabel或供计算使用
+//读取一次传感器数据，显示在相应的qlabel或供计算使用
+//设备在第一次调用时打开，之后一直复用同一个 fd（见 SensorHandle）
+//TempHumidity 返回 (温度x10 << 16) | 湿度x10，需要浮点值的调用方直接用 Dht11Reader
+//LightLevel 读取失败或还没有有效读数时返回 -1
 int DataProcess(ProcessMode mode);
 
+//读取一次超声波回波时间（us），失败返回 -1；供需要原始值做滤波的调用方使用
+long long UltrasonicEcho();
+
+// 照度的采集方式：直接访问 /dev/i2c-0（默认），或经内核 IIO 驱动（bh1750）
+enum LightBackend {
+    LightI2c,
+    LightIio
+};
+//选择照度采集方式，任意线程可调用；未调用时按环境变量 LIGHT_BACKEND=i2c|iio
+void setLightBackend(LightBackend backend);
+
 
 
-//根据广谱气体的返回数据调用LED蜂鸣器进行警告
-void WarningGas(int gas);
+//广谱气体超标时的 LED/蜂鸣器警告由 SensorScheduler 在采样线程里驱动，
+//LEDBuzzer 设备只由它打开
 
 
 //根据超声波的数据设定距离警告
@@ -0,0 +1,72 @@
+// dht11reader.cpp
+#include "dht11reader.h"
+#include "monotonic.h"
+#include <QDebug>
+#include <QByteArray>
+
+Dht11Reader &Dht11Reader::instance()
+{
+    static Dht11Reader reader;
+    return reader;
+}
+
+Dht11Reader::Dht11Reader()
+    : m_device("/dev/DHT11", O_RDONLY)
+{
+}
+
+bool Dht11Reader::latest(Dht11Reading *reading)
+{
+    QMutexLocker locker(&m_cacheLock);
+    if (m_valid && reading) *reading = m_cache;
+    return m_valid;
+}
+
+bool Dht11Reader::measureDue(qint64 now) const
+{
+    qint64 last = m_lastMeasureUs;
+    return last == 0 || now - last >= (DHT11_MIN_INTERVAL_MS - DHT11_INTERVAL_SLACK_MS) * 1000LL;
+}
+
+bool Dht11Reader::update(Dht11Reading *reading)
+{
+    // 没到期，或者别的线程正在读设备（约 25ms）时直接拿缓存，不在设备锁上排队
+    if (measureDue(monotonicUs()) && m_deviceLock.tryLock()) {
+        qint64 now = monotonicUs();
+        // 拿到锁之前别的线程可能刚测完
+        if (measureDue(now)) {
+            // 失败也算一次测量，避免传感器出错时被连续触发
+            m_lastMeasureUs = now;
+            Dht11Reading fresh;
+            if (measure(&fresh)) {
+                QMutexLocker cache(&m_cacheLock);
+                m_cache = fresh;
+                m_valid = true;
+            }
+        }
+        m_deviceLock.unlock();
+    }
+    return latest(reading);
+}
+
+bool Dht11Reader::measure(Dht11Reading *reading)
+{
+    // 驱动返回 湿度整数、湿度小数、温度整数、温度小数、校验和
+    unsigned char buf[6];
+    ssize_t n = m_device.read(buf, sizeof(buf));
+    // 打不开或设备丢失时 SensorHandle 已经记录过
+    if (n < 0) return false;
+    if (n < 5) {
+        qDebug() << "DHT11 short read n =" << n;
+        return false;
+    }
+    uint8_t sum = buf[0] + buf[1] + buf[2] + buf[3];
+    if (buf[4] != sum) {
+        qDebug() << "DHT11 checksum mismatch" << QByteArray((char*)buf, n).toHex();
+        return false;
+    }
+    reading->humidity    = buf[0] + buf[1] / 10.0f;
+    reading->temperature = buf[2] + buf[3] / 10.0f;
+    reading->timestampUs = monotonicUs();
+    return true;
+}
@@ -0,0 +1,56 @@
+// dht11reader.h
+#ifndef DHT11READER_H
+#define DHT11READER_H
+
+#include <QMutex>
+#include <atomic>
+#include "sensorhandle.h"
+
+// DHT11 两次测量之间至少间隔 1s，这里留足余量
+#define DHT11_MIN_INTERVAL_MS 2000
+// 按测量间隔调度的调用方可能早到几毫秒，差这么多以内仍算到期
+#define DHT11_INTERVAL_SLACK_MS 50
+
+// 一次有效的温湿度读数
+struct Dht11Reading {
+    float   temperature = 0;    // ℃
+    float   humidity    = 0;    // %RH
+    qint64  timestampUs = 0;    // 读到时的 CLOCK_MONOTONIC 时间
+};
+
+/**
+ * @brief Dht11Reader
+ * 全进程共用的 DHT11 读取器，直接读 /dev/DHT11，不再启动样例程序。
+ *
+ * 设备只在距上次测量超过 DHT11_MIN_INTERVAL_MS 时才真正读取，其余调用
+ * 直接返回缓存的最近一次有效读数（校验失败的帧丢弃，缓存保持不变），
+ * 因此多个消费者同时调用也不会让传感器测量过密。是否到期用原子时间戳判断，
+ * 不到期或另一线程正在读设备时不碰设备锁，调用方拿到缓存只需一次短暂加锁。
+ */
+class Dht11Reader
+{
+public:
+    static Dht11Reader &instance();
+
+    // 最近一次有效读数，不访问设备；还没有有效读数时返回 false
+    bool latest(Dht11Reading *reading);
+    // 到期时先测量一次再返回最近一次有效读数；其它线程正在测量时不等待，直接返回缓存
+    bool update(Dht11Reading *reading);
+
+private:
+    Dht11Reader();
+    Dht11Reader(const Dht11Reader &) = delete;
+    Dht11Reader &operator=(const Dht11Reader &) = delete;
+
+    bool measure(Dht11Reading *reading);
+    bool measureDue(qint64 now) const;
+
+    QMutex        m_deviceLock;         // 串行化设备访问，保护 m_device
+    SensorHandle  m_device;
+    std::atomic<qint64> m_lastMeasureUs{0};     // 只在持有 m_deviceLock 时写
+    QMutex        m_cacheLock;
+    Dht11Reading  m_cache;              // 受 m_cacheLock 保护
+    bool          m_valid = false;
+};
+
+#endif // DHT11READER_H
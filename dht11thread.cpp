@@ -1,33 +1,17 @@
 #include "dht11thread.h"
-#include <QDebug>
-#include <fcntl.h>
-#include <unistd.h>
-#include <errno.h>
-#include <string.h>
+#include "dht11reader.h"
 
 DHT11Thread::DHT11Thread(QObject *parent)
     : QThread(parent) {}
 
 void DHT11Thread::run()
 {
-    int fd = open("/dev/DHT11", O_RDONLY);
-    if (fd < 0) {
-        qDebug() << "DHT11 open failed:" << strerror(errno);
-        return;
-    }
-
-    unsigned char buf[5];
+    // 设备由 Dht11Reader 统一读取，这里只按测量间隔取最新值
     while (!isInterruptionRequested()) {
-        int bytesRead = ::read(fd, buf, sizeof(buf));
-        if (bytesRead == sizeof(buf)) {
-            uint8_t sum = buf[0] + buf[1] + buf[2] + buf[3];
-            if (buf[4] == sum) {
-                int hum  = buf[0];   // 整数湿度 %
-                int temp = buf[2];   // 整数温度 ℃
-                emit newTempHum(temp, hum);   // 发 int 即可
-            }
+        Dht11Reading reading;
+        if (Dht11Reader::instance().update(&reading)) {
+            emit newTempHum(reading.temperature, reading.humidity);
         }
-        msleep(2000);
+        msleep(DHT11_MIN_INTERVAL_MS);
     }
-    ::close(fd);
 }
@@ -16,12 +16,10 @@ public:
 
 signals:
     /**
-     * @param tempInt   温度整数部分
-     * @param tempFrac  温度小数部分
-     * @param humidity  湿度整数部分
+     * @param temperature 温度（℃，保留驱动给出的小数）
+     * @param humidity    湿度（%RH）
      */
-signals:
-    void newTempHum(int temperature, int humidity);   // 推荐 int
+    void newTempHum(float temperature, float humidity);
 
 protected:
     void run() override;
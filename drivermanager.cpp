@@ -0,0 +1,133 @@
+// drivermanager.cpp
+#include "drivermanager.h"
+#include "monotonic.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+DriverManager &DriverManager::instance()
+{
+    // 不析构：shutdown() 超时后加载线程可能在 main() 返回后才结束
+    static DriverManager *manager = new DriverManager;
+    return *manager;
+}
+
+QSet<QString> DriverManager::loadedModules()
+{
+    // 每行第一个字段是模块名
+    QSet<QString> names;
+    QFile file("/proc/modules");
+    if (!file.open(QIODevice::ReadOnly)) return names;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        int end = line.indexOf(' ');
+        if (end > 0) names.insert(QString::fromLatin1(line.left(end)));
+    }
+    return names;
+}
+
+QString DriverManager::moduleName(const QString &path)
+{
+    // 内核里模块名中的 '-' 统一记为 '_'
+    return QFileInfo(path).completeBaseName().replace('-', '_');
+}
+
+ModuleLoad DriverManager::loadModule(const QString &path)
+{
+    ModuleLoad load;
+    load.name = moduleName(path);
+    qint64 t0 = monotonicUs();
+
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        load.error = errno;
+        return load;
+    }
+#ifdef SYS_finit_module
+    long ret = syscall(SYS_finit_module, fd, "", 0);
+#else
+    // 内核头文件太老时读进内存再用 init_module
+    QFile file;
+    QByteArray image;
+    if (file.open(fd, QIODevice::ReadOnly)) image = file.readAll();
+    long ret = syscall(SYS_init_module, image.constData(), (unsigned long)image.size(), "");
+#endif
+    // 与启动检查之间被别人加载了也算成功
+    if (ret < 0 && errno != EEXIST) load.error = errno;
+    ::close(fd);
+    load.elapsedUs = monotonicUs() - t0;
+    return load;
+}
+
+void DriverManager::loadAsync(const QStringList &paths)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_started) return;
+    m_started = true;
+    m_startUs = monotonicUs();
+
+    QSet<QString> loaded = loadedModules();
+    for (const QString &path : paths) {
+        QString name = moduleName(path);
+        if (loaded.contains(name)) {
+            ModuleLoad load;
+            load.name    = name;
+            load.present = true;
+            m_results.append(load);
+            continue;
+        }
+        ++m_running;
+        std::thread([this, path]() { finished(loadModule(path)); }).detach();
+    }
+}
+
+void DriverManager::finished(const ModuleLoad &load)
+{
+    // 在加载线程里完成时立即输出，不等到有人调用 waitLoaded()
+    if (load.error) {
+        qWarning() << "load module" << load.name << "failed:" << strerror(load.error);
+    } else {
+        qDebug() << "module" << load.name << "loaded in" << load.elapsedUs / 1000 << "ms";
+    }
+    QMutexLocker locker(&m_mutex);
+    m_results.append(load);
+    if (--m_running == 0) {
+        qDebug() << "drivers ready in" << (monotonicUs() - m_startUs) / 1000 << "ms";
+    }
+    m_done.wakeAll();
+}
+
+bool DriverManager::waitLoaded()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_running > 0 && !m_shutdown) m_done.wait(&m_mutex);
+    if (m_running > 0) return false;
+    for (const ModuleLoad &load : m_results) {
+        if (load.error) return false;
+    }
+    return true;
+}
+
+QVector<ModuleLoad> DriverManager::results()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_results;
+}
+
+void DriverManager::shutdown(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 deadlineUs = monotonicUs() + timeoutMs * 1000LL;
+    while (m_running > 0) {
+        qint64 leftMs = (deadlineUs - monotonicUs()) / 1000;
+        if (leftMs <= 0 || !m_done.wait(&m_mutex, (unsigned long)leftMs)) break;
+    }
+    if (m_running > 0) qWarning() << m_running << "driver loads still running at exit";
+    m_shutdown = true;
+    m_done.wakeAll();
+}
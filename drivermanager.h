@@ -0,0 +1,70 @@
+// drivermanager.h
+#ifndef DRIVERMANAGER_H
+#define DRIVERMANAGER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+// 退出时等待仍在加载的模块的上限
+#define DRIVER_SHUTDOWN_TIMEOUT_MS 1000
+
+// 一个内核模块的加载结果
+struct ModuleLoad {
+    QString  name;
+    qint64   elapsedUs = 0;
+    int      error     = 0;         // 0 成功，否则为 errno
+    bool     present   = false;     // 启动前已在 /proc/modules 中，未加载
+};
+
+/**
+ * @brief DriverManager
+ * 传感器驱动的一次性加载器，代替每次 insmod。
+ *
+ * loadAsync() 在进程里只生效一次：先读 /proc/modules 跳过已加载的模块，
+ * 其余每个模块一个线程直接调用 finit_module 并行加载，立即返回，不阻塞 GUI。
+ * 每个模块加载完成时立即输出耗时，全部完成时输出总耗时。
+ * 需要设备的一方（传感器调度线程）在开始采样前调用 waitLoaded()。
+ * 这些模块之间没有符号依赖，可以并行加载。
+ *
+ * 加载线程是分离的；进程退出前由 main() 调用 shutdown()，最多等待
+ * timeoutMs，卡在内核里的加载不会拖住退出。实例本身故意不析构，
+ * 超时后才结束的加载线程仍可安全地写回结果。
+ */
+class DriverManager
+{
+public:
+    static DriverManager &instance();
+
+    // 后台加载 paths 中尚未加载的 .ko；重复调用无效
+    void loadAsync(const QStringList &paths);
+    // 等待加载结束；全部可用时返回 true，shutdown() 之后立即返回
+    bool waitLoaded();
+    // 各模块的加载结果，waitLoaded() 之后有效
+    QVector<ModuleLoad> results();
+    // 退出前调用：最多等待 timeoutMs 让仍在进行的加载结束，并唤醒 waitLoaded()
+    void shutdown(int timeoutMs = DRIVER_SHUTDOWN_TIMEOUT_MS);
+
+private:
+    DriverManager() = default;
+    DriverManager(const DriverManager &) = delete;
+    DriverManager &operator=(const DriverManager &) = delete;
+
+    static QSet<QString> loadedModules();
+    static QString moduleName(const QString &path);
+    static ModuleLoad loadModule(const QString &path);
+    void finished(const ModuleLoad &load);
+
+    QMutex               m_mutex;
+    QWaitCondition       m_done;
+    bool                 m_started = false;
+    bool                 m_shutdown = false;
+    qint64               m_startUs = 0;
+    int                  m_running = 0;         // 尚未完成的加载线程数
+    QVector<ModuleLoad>  m_results;
+};
+
+#endif // DRIVERMANAGER_H
@@ -0,0 +1,55 @@
+// framemailbox.cpp
+
+#include "framemailbox.h"
+#include <QDebug>
+
+FrameMailbox::FrameMailbox(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FrameMailbox::post(const QImage &frame, const FrameInfo &info)
+{
+    bool notify;
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_posted;
+        if (m_full) {
+            // 消费者还没取走上一帧：覆盖，不再排队
+            if (m_dropped++ % 100 == 0) {
+                qDebug() << "[FrameMailbox] consumer behind, dropped" << m_dropped
+                         << "of" << m_posted << "frames";
+            }
+        }
+        notify = !m_full;
+        m_frame = frame;
+        m_info  = info;
+        m_full  = true;
+    }
+    // 放在锁外发信号；跨线程时为排队连接，只在空->满时投递一次
+    if (notify) emit frameAvailable();
+}
+
+bool FrameMailbox::take(QImage *frame, FrameInfo *info)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_full) return false;
+    *frame = m_frame;
+    if (info) *info = m_info;
+    // 清空槽，帧池槽位随最后一个 QImage 副本归还
+    m_frame = QImage();
+    m_full  = false;
+    return true;
+}
+
+quint64 FrameMailbox::posted()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_posted;
+}
+
+quint64 FrameMailbox::dropped()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
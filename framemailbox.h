@@ -0,0 +1,47 @@
+// framemailbox.h
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include "framestats.h"
+
+/**
+ * @brief FrameMailbox
+ * 单槽“最新帧优先”邮箱，放在采集线程与 GUI 之间。
+ *
+ * post() 在采集线程里直接调用（DirectConnection），槽里已有未取走的帧时
+ * 用新帧覆盖并计入丢帧；只有槽从空变满时才发出 frameAvailable，因此每个
+ * 消费者的事件队列里最多只有一个待处理的帧通知，GUI 卡顿时内存不会增长。
+ * 消费者在 frameAvailable 的槽里调用 take() 取最新帧。
+ */
+class FrameMailbox : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameMailbox(QObject *parent = nullptr);
+
+    // 取走最新帧及其采集信息；槽为空时返回 false
+    bool take(QImage *frame, FrameInfo *info = nullptr);
+
+    quint64 posted();
+    quint64 dropped();
+
+public slots:
+    // 任意线程调用
+    void post(const QImage &frame, const FrameInfo &info);
+
+signals:
+    void frameAvailable();
+
+private:
+    QMutex  m_mutex;
+    QImage  m_frame;
+    FrameInfo m_info;
+    bool    m_full    = false;
+    quint64 m_posted  = 0;
+    quint64 m_dropped = 0;     // 被新帧覆盖、从未显示的帧数
+};
+
+#endif // FRAMEMAILBOX_H
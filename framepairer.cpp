@@ -0,0 +1,110 @@
+// framepairer.cpp
+
+#include "framepairer.h"
+#include <QDebug>
+
+FramePairer::FramePairer(qint64 maxSkewUs, QObject *parent)
+    : QObject(parent)
+    , m_maxSkewUs(maxSkewUs)
+    // 约 10 个配对窗口没有新帧即视为该路停流
+    , m_staleUs(maxSkewUs * 10)
+{
+}
+
+void FramePairer::postFirst(const QImage &frame, const FrameInfo &info)
+{
+    post(0, frame, info);
+}
+
+void FramePairer::postSecond(const QImage &frame, const FrameInfo &info)
+{
+    post(1, frame, info);
+}
+
+void FramePairer::post(int source, const QImage &frame, const FrameInfo &info)
+{
+    int other = 1 - source;
+    bool notify = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastSeen[source] = info.timestampUs;
+
+        // 本路队列满时丢掉最旧的一帧
+        Entry *mine = m_pending[source];
+        if (m_count[source] == PAIRER_DEPTH) {
+            for (int i = 1; i < PAIRER_DEPTH; ++i) mine[i - 1] = mine[i];
+            mine[--m_count[source]] = Entry();
+            m_dropped++;
+        }
+        mine[m_count[source]].image = frame;
+        mine[m_count[source]].info  = info;
+        m_count[source]++;
+
+        // 在另一路里找时间最接近的帧
+        Entry *theirs = m_pending[other];
+        int best = -1;
+        qint64 bestDiff = 0;
+        for (int i = 0; i < m_count[other]; ++i) {
+            qint64 diff = qAbs(theirs[i].info.timestampUs - info.timestampUs);
+            if (best < 0 || diff < bestDiff) {
+                best = i;
+                bestDiff = diff;
+            }
+        }
+
+        FramePair pair;
+        if (best >= 0 && bestDiff <= m_maxSkewUs) {
+            pair.image[source] = frame;
+            pair.info[source]  = info;
+            pair.image[other]  = theirs[best].image;
+            pair.info[other]   = theirs[best].info;
+            // 时间戳单调递增，配上的帧及更旧的帧都不会再有更好的搭档
+            m_dropped += best;
+            for (int i = best + 1; i < m_count[other]; ++i) theirs[i - best - 1] = theirs[i];
+            for (int i = m_count[other] - best - 1; i < m_count[other]; ++i) theirs[i] = Entry();
+            m_count[other] -= best + 1;
+            m_dropped += m_count[source] - 1;
+            for (int i = 0; i < m_count[source]; ++i) mine[i] = Entry();
+            m_count[source] = 0;
+            m_paired++;
+            deliver(pair, &notify);
+        } else if (info.timestampUs - m_lastSeen[other] > m_staleUs) {
+            // 另一路已停流：单独送出
+            pair.image[source] = frame;
+            pair.info[source]  = info;
+            mine[--m_count[source]] = Entry();
+            deliver(pair, &notify);
+        }
+    }
+    if (notify) emit pairAvailable();
+}
+
+void FramePairer::deliver(const FramePair &pair, bool *notify)
+{
+    if (m_full) m_dropped++;
+    *notify = !m_full;
+    m_out  = pair;
+    m_full = true;
+}
+
+bool FramePairer::take(FramePair *pair)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_full) return false;
+    *pair = m_out;
+    m_out  = FramePair();
+    m_full = false;
+    return true;
+}
+
+quint64 FramePairer::paired()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_paired;
+}
+
+quint64 FramePairer::dropped()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
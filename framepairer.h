@@ -0,0 +1,71 @@
+// framepairer.h
+#ifndef FRAMEPAIRER_H
+#define FRAMEPAIRER_H
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include "framestats.h"
+
+// 两路摄像头同一时刻的一组帧；某一路停流时另一路单独送出，对应 image 为空
+struct FramePair {
+    QImage    image[2];
+    FrameInfo info[2];
+
+    bool   complete() const { return !image[0].isNull() && !image[1].isNull(); }
+    qint64 skewUs() const   { return info[0].timestampUs - info[1].timestampUs; }
+};
+
+/**
+ * @brief FramePairer
+ * 按驱动时间戳把两路采集线程的帧配成对。
+ *
+ * 两个 post 槽以 DirectConnection 连到各自 cameraThread 的帧信号，
+ * 在采集线程里执行：每路只保留最近 PAIRER_DEPTH 帧，新帧到达时在另一路
+ * 中找时间差最小且不超过 maxSkewUs 的帧组成一对，较旧的帧随之丢弃。
+ * 另一路超过 staleUs 没有新帧时，当前帧单独送出，避免一路掉线拖住另一路。
+ * 输出与 FrameMailbox 相同：单槽、最新优先，只在空->满时发 pairAvailable。
+ * 只搬运 QImage 引用，不做拷贝，两路各自的转换开销不变。
+ */
+class FramePairer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FramePairer(qint64 maxSkewUs, QObject *parent = nullptr);
+
+    bool take(FramePair *pair);
+
+    quint64 paired();
+    quint64 dropped();
+
+public slots:
+    void postFirst(const QImage &frame, const FrameInfo &info);
+    void postSecond(const QImage &frame, const FrameInfo &info);
+
+signals:
+    void pairAvailable();
+
+private:
+    enum { PAIRER_DEPTH = 2 };
+
+    struct Entry {
+        QImage    image;
+        FrameInfo info;
+    };
+
+    void post(int source, const QImage &frame, const FrameInfo &info);
+    void deliver(const FramePair &pair, bool *notify);
+
+    QMutex    m_mutex;
+    qint64    m_maxSkewUs;
+    qint64    m_staleUs;
+    Entry     m_pending[2][PAIRER_DEPTH];
+    int       m_count[2] = { 0, 0 };
+    qint64    m_lastSeen[2] = { 0, 0 };
+    FramePair m_out;
+    bool      m_full    = false;
+    quint64   m_paired  = 0;
+    quint64   m_dropped = 0;
+};
+
+#endif // FRAMEPAIRER_H
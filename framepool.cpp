@@ -0,0 +1,101 @@
+// framepool.cpp
+
+#include "framepool.h"
+#include <QDebug>
+#include <stdlib.h>
+
+FramePool *FramePool::create(int slotCount, int slotBytes, int align)
+{
+    // 至少按缓存行对齐，方便向量内核使用
+    FramePool *pool = new FramePool(slotCount, slotBytes, qMax(align, 64));
+    if (!pool->m_memory) {
+        delete pool;
+        return nullptr;
+    }
+    return pool;
+}
+
+FramePool::FramePool(int slotCount, int slotBytes, int align)
+    : m_memory(nullptr)
+    , m_slotBytes((slotBytes + align - 1) & ~(align - 1))
+    , m_ref(1)
+{
+    void *mem = nullptr;
+    if (posix_memalign(&mem, align, (size_t)m_slotBytes * slotCount) != 0) {
+        qCritical() << "FramePool: failed to allocate" << slotCount << "x" << m_slotBytes;
+        return;
+    }
+    m_memory = (unsigned char*)mem;
+
+    m_slots.resize(slotCount);
+    m_free.reserve(slotCount);
+    for (int i = 0; i < slotCount; ++i) {
+        m_slots[i].pool = this;
+        m_slots[i].data = m_memory + (size_t)i * m_slotBytes;
+        m_free.append(&m_slots[i]);
+    }
+}
+
+FramePool::~FramePool()
+{
+    free(m_memory);
+}
+
+void FramePool::release()
+{
+    deref();
+}
+
+void FramePool::deref()
+{
+    if (!m_ref.deref()) delete this;
+}
+
+unsigned char *FramePool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_free.isEmpty()) return nullptr;
+    Slot *slot = m_free.last();
+    m_free.remove(m_free.size() - 1);
+    m_ref.ref();
+    return slot->data;
+}
+
+FramePool::Slot *FramePool::slotOf(unsigned char *data)
+{
+    return &m_slots[(int)((data - m_memory) / m_slotBytes)];
+}
+
+QImage FramePool::wrap(unsigned char *data, int width, int height,
+                       int bytesPerLine, QImage::Format format)
+{
+    return QImage(data, width, height, bytesPerLine, format,
+                  &FramePool::cleanup, slotOf(data));
+}
+
+void FramePool::recycle(unsigned char *data)
+{
+    put(slotOf(data));
+}
+
+void FramePool::put(Slot *slot)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_free.append(slot);
+    }
+    deref();
+}
+
+void FramePool::cleanup(void *info)
+{
+    // 最后一个 QImage 副本析构时调用，可能发生在任意线程
+    Slot *slot = static_cast<Slot*>(info);
+    slot->pool->put(slot);
+}
+
+int FramePool::freeCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_free.size();
+}
@@ -0,0 +1,62 @@
+// framepool.h
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+
+/**
+ * @brief FramePool
+ * 固定数量、预先分配的帧缓冲池。
+ *
+ * wrap() 生成的 QImage 通过 cleanup 回调持有一个槽位，最后一个 QImage
+ * 副本析构时槽位自动回到空闲队列，跨线程传递时无需深拷贝。
+ * 池本身也做引用计数：创建者调用 release() 后，要等所有在外的帧都
+ * 归还才真正释放内存，因此帧可以比采集线程活得更久。
+ */
+class FramePool
+{
+public:
+    // align 为槽起始地址对齐（2 的幂），默认按缓存行；作 V4L2 USERPTR 缓冲时需按页
+    static FramePool *create(int slotCount, int slotBytes, int align = 64);
+    // 创建者放弃所有权
+    void release();
+
+    // 取一个空闲槽；池已耗尽时返回 nullptr（调用方应丢弃该帧）
+    unsigned char *acquire();
+    // 把已填充的槽包装为 QImage，所有权转移给 QImage
+    QImage wrap(unsigned char *data, int width, int height,
+                int bytesPerLine, QImage::Format format);
+    // 未包装的槽直接归还（如转换失败）
+    void recycle(unsigned char *data);
+
+    int slotBytes() const { return m_slotBytes; }
+    int slotCount() const { return m_slots.size(); }
+    int freeCount();
+
+private:
+    struct Slot {
+        FramePool     *pool;
+        unsigned char *data;
+    };
+
+    FramePool(int slotCount, int slotBytes, int align);
+    ~FramePool();
+    Q_DISABLE_COPY(FramePool)
+
+    Slot *slotOf(unsigned char *data);
+    void  put(Slot *slot);
+    void  deref();
+    static void cleanup(void *info);
+
+    unsigned char  *m_memory;
+    int             m_slotBytes;
+    QVector<Slot>   m_slots;
+    QVector<Slot*>  m_free;
+    QMutex          m_mutex;
+    QAtomicInt      m_ref;      // 创建者 1 + 在外的槽数
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,144 @@
+// framering.cpp
+
+#include "framering.h"
+#include "yuvconvert.h"
+#include <string.h>
+
+QImage RingFrame::toImage() const
+{
+    if (isNull()) return QImage();
+    if (isJpeg()) return QImage::fromData(data, "JPG");
+
+    QImage img(width, height, QImage::Format_RGB888);
+    const unsigned char *src = (const unsigned char*)data.constData();
+    if (pixelformat == V4L2_PIX_FMT_NV12) {
+        nv12_to_rgb888(src, bytesPerLine, src + bytesPerLine * height, bytesPerLine,
+                       img.bits(), img.bytesPerLine(), width, height);
+    } else {
+        yuyv_to_rgb888(src, bytesPerLine, img.bits(), img.bytesPerLine(), width, height);
+    }
+    return img;
+}
+
+double laplacianVariance(const unsigned char *y, int ystep, int stride,
+                         int width, int height)
+{
+    // 只看中间一半区域（被测物通常在画面中央），隔一像素采样
+    int x0 = width / 4, x1 = width * 3 / 4;
+    int y0 = height / 4, y1 = height * 3 / 4;
+    if (x1 - x0 < 6 || y1 - y0 < 6) return 0;
+
+    long long sum = 0, sumSq = 0, n = 0;
+    for (int row = y0 + 2; row < y1 - 2; row += 2) {
+        const unsigned char *up   = y + (row - 2) * stride;
+        const unsigned char *line = y + row * stride;
+        const unsigned char *down = y + (row + 2) * stride;
+        for (int col = x0 + 2; col < x1 - 2; col += 2) {
+            int c   = col * ystep;
+            int lap = 4 * line[c] - line[c - 2 * ystep] - line[c + 2 * ystep]
+                    - up[c] - down[c];
+            sum   += lap;
+            sumSq += lap * lap;
+            n++;
+        }
+    }
+    if (n == 0) return 0;
+    double mean = (double)sum / n;
+    return (double)sumSq / n - mean * mean;
+}
+
+double imageFocus(const QImage &image, QVector<unsigned char> *luma)
+{
+    QImage img = image;
+    if (img.format() != QImage::Format_RGB32 && img.format() != QImage::Format_ARGB32) {
+        img = img.convertToFormat(QImage::Format_RGB32);
+    }
+    int w = img.width(), h = img.height();
+    if (w == 0 || h == 0) return 0;
+    luma->resize(w * h);
+    unsigned char *dst = luma->data();
+    for (int y = 0; y < h; ++y) {
+        const QRgb *line = (const QRgb*)img.constScanLine(y);
+        for (int x = 0; x < w; ++x) {
+            QRgb p = line[x];
+            *dst++ = (unsigned char)((77 * qRed(p) + 150 * qGreen(p) + 29 * qBlue(p)) >> 8);
+        }
+    }
+    return laplacianVariance(luma->constData(), 1, w, w, h);
+}
+
+FrameRing::FrameRing(int windowMs, int buckets)
+    : m_bucketUs((qint64)windowMs * 1000 / qMax(buckets, 1))
+    , m_frames(qMax(buckets, 1))
+    , m_bucketIds(qMax(buckets, 1), -1)
+{
+    if (m_bucketUs <= 0) m_bucketUs = 1;
+}
+
+RingFrame *FrameRing::slotFor(const FrameInfo &info, double focus)
+{
+    qint64 id = info.timestampUs / m_bucketUs;
+    int index = (int)(id % m_frames.size());
+    if (m_bucketIds[index] != id) {
+        // 新的时间格：覆盖一整个窗口之前的旧帧
+        m_bucketIds[index] = id;
+        m_frames[index].focus = -1;
+    }
+    if (focus <= m_frames[index].focus) return nullptr;
+    return &m_frames[index];
+}
+
+void FrameRing::addRaw(const FrameInfo &info, double focus, const unsigned char *data, int size,
+                       __u32 pixelformat, int width, int height, int bytesPerLine)
+{
+    QMutexLocker locker(&m_mutex);
+    RingFrame *frame = slotFor(info, focus);
+    if (!frame) return;
+    // 容量够时原地覆盖；仍被读者共享时 data() 自动分离
+    frame->data.resize(size);
+    memcpy(frame->data.data(), data, size);
+    frame->info         = info;
+    frame->focus        = focus;
+    frame->pixelformat  = pixelformat;
+    frame->width        = width;
+    frame->height       = height;
+    frame->bytesPerLine = bytesPerLine;
+}
+
+void FrameRing::addJpeg(const FrameInfo &info, double focus, const QByteArray &jpeg,
+                        int width, int height)
+{
+    QMutexLocker locker(&m_mutex);
+    RingFrame *frame = slotFor(info, focus);
+    if (!frame) return;
+    frame->data         = jpeg;
+    frame->info         = info;
+    frame->focus        = focus;
+    frame->pixelformat  = V4L2_PIX_FMT_MJPEG;
+    frame->width        = width;
+    frame->height       = height;
+    frame->bytesPerLine = 0;
+}
+
+bool FrameRing::bucketEmpty(const FrameInfo &info)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 id = info.timestampUs / m_bucketUs;
+    int index = (int)(id % m_frames.size());
+    return m_bucketIds[index] != id || m_frames[index].focus < 0;
+}
+
+bool FrameRing::sharpest(RingFrame *frame, qint64 nowUs)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 oldest = nowUs / m_bucketUs - m_frames.size();
+    const RingFrame *best = nullptr;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_bucketIds[i] < 0 || m_bucketIds[i] <= oldest) continue;
+        if (m_frames[i].isNull()) continue;
+        if (!best || m_frames[i].focus > best->focus) best = &m_frames[i];
+    }
+    if (!best) return false;
+    *frame = *best;
+    return true;
+}
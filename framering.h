@@ -0,0 +1,77 @@
+// framering.h
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <QMetaType>
+#include <linux/videodev2.h>
+#include "framestats.h"
+
+// 环中保存的一帧：原始 YUYV/NV12 数据或 MJPEG 码流
+struct RingFrame {
+    FrameInfo  info;
+    double     focus        = 0;    // 清晰度评分，只在同一格式的帧之间可比
+    QByteArray data;
+    __u32      pixelformat  = 0;
+    int        width        = 0;
+    int        height       = 0;
+    int        bytesPerLine = 0;
+
+    bool   isNull() const { return data.isEmpty(); }
+    bool   isJpeg() const { return pixelformat == V4L2_PIX_FMT_MJPEG; }
+    // 转为全分辨率 RGB888（MJPEG 则解码），可在任意线程调用
+    QImage toImage() const;
+};
+Q_DECLARE_METATYPE(RingFrame)
+
+/**
+ * 聚焦评分：Y 平面中间一半区域上，隔一像素采样的拉普拉斯算子方差。
+ * 越大越清晰；ystep 为相邻 Y 样本的字节间隔（YUYV 为 2，NV12 为 1）。
+ */
+double laplacianVariance(const unsigned char *y, int ystep, int stride,
+                         int width, int height);
+/**
+ * 已解码图像（如 MJPEG 的预览帧）的聚焦评分：先按 BT.601 系数算出亮度，
+ * 再同 laplacianVariance。luma 为调用方保留的暂存区，尺寸不变时不再分配。
+ */
+double imageFocus(const QImage &image, QVector<unsigned char> *luma);
+
+/**
+ * @brief FrameRing
+ * 触发前帧环：保留最近 windowMs 毫秒内的帧，供识别时挑最清晰的一帧。
+ *
+ * 窗口按时间等分为若干格，每格只保留评分最高的一帧，因此内存固定为
+ * 格数 x 单帧大小，与帧率无关；新帧只在比所在格当前帧更清晰时才拷贝。
+ * 采集线程写入，任意线程读取；读出的帧与环共享数据，之后被覆盖时自动分离。
+ */
+class FrameRing
+{
+public:
+    FrameRing(int windowMs, int buckets);
+
+    // 原始帧：在评分胜出时拷贝 size 字节
+    void addRaw(const FrameInfo &info, double focus, const unsigned char *data, int size,
+                __u32 pixelformat, int width, int height, int bytesPerLine);
+    // MJPEG 帧：只增加引用计数
+    void addJpeg(const FrameInfo &info, double focus, const QByteArray &jpeg,
+                 int width, int height);
+
+    // nowUs（CLOCK_MONOTONIC）之前 windowMs 内最清晰的一帧；更早的帧即使还在环里也不算，
+    // 因此暂停采集一段时间后不会取到过期的帧。窗口内没有帧时返回 false
+    bool sharpest(RingFrame *frame, qint64 nowUs);
+    // info 所在的时间格当前还没有帧：此时任何评分的帧都会被收下
+    bool bucketEmpty(const FrameInfo &info);
+
+private:
+    RingFrame *slotFor(const FrameInfo &info, double focus);
+
+    QMutex             m_mutex;
+    qint64             m_bucketUs;
+    QVector<RingFrame> m_frames;
+    QVector<qint64>    m_bucketIds;     // 每格对应的时间格序号，-1 为空
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,107 @@
+// framestats.cpp
+
+#include "framestats.h"
+#include <string.h>
+
+void LatencyHistogram::reset()
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum   = 0;
+    m_max   = 0;
+}
+
+void LatencyHistogram::add(qint64 us)
+{
+    if (us < 0) us = 0;
+    int bucket = 0;
+    while (bucket < Buckets - 1 && (us >> (bucket + 1)) != 0) ++bucket;
+    m_buckets[bucket]++;
+    m_count++;
+    m_sum += us;
+    if (us > m_max) m_max = us;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0) return 0;
+    quint64 target = (quint64)(p / 100.0 * m_count + 0.5);
+    if (target == 0) target = 1;
+    quint64 seen = 0;
+    for (int i = 0; i < Buckets; ++i) {
+        seen += m_buckets[i];
+        if (seen >= target) return qMin((qint64)2 << i, m_max);
+    }
+    return m_max;
+}
+
+QString LatencyHistogram::summary() const
+{
+    return QString("mean %1 us, p50 %2 us, p99 %3 us, max %4 us")
+            .arg(mean()).arg(percentile(50)).arg(percentile(99)).arg(max());
+}
+
+QString FrameStatsSnapshot::summary() const
+{
+    return QString("captured %1, driver gaps %2, error %3, pool drops %4, unchanged %5; "
+                   "convert: %6; display latency: %7")
+            .arg(captured).arg(sequenceGaps).arg(errorFrames).arg(poolDrops).arg(unchanged)
+            .arg(convert.summary()).arg(display.summary());
+}
+
+void FrameStats::streamStarted()
+{
+    QMutexLocker locker(&m_mutex);
+    m_haveSequence = false;
+}
+
+quint64 FrameStats::frameDequeued(const FrameInfo &info, bool error)
+{
+    QMutexLocker locker(&m_mutex);
+    m_data.captured++;
+    if (error) m_data.errorFrames++;
+    if (m_haveSequence && info.sequence > m_lastSequence + 1) {
+        m_data.sequenceGaps += info.sequence - m_lastSequence - 1;
+    }
+    m_lastSequence = info.sequence;
+    m_haveSequence = true;
+    return m_data.captured;
+}
+
+void FrameStats::frameDropped()
+{
+    QMutexLocker locker(&m_mutex);
+    m_data.poolDrops++;
+}
+
+void FrameStats::frameUnchanged()
+{
+    QMutexLocker locker(&m_mutex);
+    m_data.unchanged++;
+}
+
+void FrameStats::frameConverted(qint64 us)
+{
+    QMutexLocker locker(&m_mutex);
+    m_data.convert.add(us);
+}
+
+void FrameStats::frameDisplayed(const FrameInfo &info)
+{
+    if (info.dequeuedUs <= 0) return;
+    qint64 latency = monotonicUs() - info.dequeuedUs;
+    QMutexLocker locker(&m_mutex);
+    m_data.display.add(latency);
+}
+
+FrameStatsSnapshot FrameStats::snapshot()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_data;
+}
+
+void FrameStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_data = FrameStatsSnapshot();
+}
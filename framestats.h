@@ -0,0 +1,86 @@
+// framestats.h
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include "monotonic.h"
+
+/**
+ * 每帧随图像一起传递的采集信息
+ */
+struct FrameInfo {
+    quint32 sequence    = 0;    // 驱动帧序号，跳号即驱动侧丢帧
+    qint64  timestampUs = 0;    // 采集时刻（CLOCK_MONOTONIC，微秒）
+    qint64  dequeuedUs  = 0;    // VIDIOC_DQBUF 返回的时刻（同一时基），显示延迟从这里算起
+};
+Q_DECLARE_METATYPE(FrameInfo)
+
+/**
+ * @brief LatencyHistogram
+ * 以 2 的幂（微秒）分桶的耗时直方图，第 i 桶为 [2^i, 2^(i+1)) us。
+ * 百分位返回所在桶的上界，足够判断量级。
+ */
+class LatencyHistogram
+{
+public:
+    enum { Buckets = 24 };      // 最大约 16 秒
+
+    LatencyHistogram() { reset(); }
+    void reset();
+    void add(qint64 us);
+
+    quint64 count() const { return m_count; }
+    qint64  mean() const  { return m_count ? m_sum / (qint64)m_count : 0; }
+    qint64  max() const   { return m_max; }
+    qint64  percentile(double p) const;
+    QString summary() const;
+
+private:
+    quint64 m_buckets[Buckets];
+    quint64 m_count;
+    qint64  m_sum;
+    qint64  m_max;
+};
+
+// 某一时刻的统计快照
+struct FrameStatsSnapshot {
+    quint64          captured     = 0;  // 成功出队的帧
+    quint64          sequenceGaps = 0;  // 驱动序号跳过的帧（内核队列满时丢弃）
+    quint64          errorFrames  = 0;  // 带 V4L2_BUF_FLAG_ERROR 的帧
+    quint64          poolDrops    = 0;  // 帧池耗尽而未转换的帧
+    quint64          unchanged    = 0;  // 场景无变化、跳过预览转换的帧
+    LatencyHistogram convert;           // 单帧转换/解码耗时
+    LatencyHistogram display;           // 出队（DQBUF）到 GUI 显示的延迟
+
+    QString summary() const;
+};
+
+/**
+ * @brief FrameStats
+ * 采集统计：采集线程写入，GUI 线程写入显示延迟，任意线程读取快照。
+ */
+class FrameStats
+{
+public:
+    // 每次开流时调用，驱动序号从 0 重新开始
+    void streamStarted();
+    // 返回累计出队帧数，调用方据此决定是否取快照输出
+    quint64 frameDequeued(const FrameInfo &info, bool error);
+    void frameDropped();
+    void frameUnchanged();
+    void frameConverted(qint64 us);
+    void frameDisplayed(const FrameInfo &info);
+
+    FrameStatsSnapshot snapshot();
+    void reset();
+
+private:
+    QMutex             m_mutex;
+    FrameStatsSnapshot m_data;
+    quint32            m_lastSequence = 0;
+    bool               m_haveSequence = false;
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,273 @@
+// iiosensor.cpp
+#include "iiosensor.h"
+#include "monotonic.h"
+#include "sensorhandle.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define IIO_SYSFS "/sys/bus/iio/devices"
+
+IioSensor::IioSensor(const QString &deviceName, const QString &channel)
+    : m_name(deviceName)
+    , m_channel(channel)
+{
+}
+
+IioSensor::~IioSensor()
+{
+    close();
+}
+
+QByteArray IioSensor::attr(const QString &name) const
+{
+    QFile file(m_sysfs + "/" + name);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll().trimmed();
+}
+
+bool IioSensor::setAttr(const QString &name, const QByteArray &value) const
+{
+    // 不带缓冲，sysfs 的写错误直接体现在 write 上
+    QFile file(m_sysfs + "/" + name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) return false;
+    return file.write(value) == value.size();
+}
+
+bool IioSensor::findDevice()
+{
+    QDir dir(IIO_SYSFS);
+    for (const QString &entry : dir.entryList(QStringList("iio:device*"))) {
+        QFile file(dir.filePath(entry) + "/name");
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        if (QString::fromLatin1(file.readAll().trimmed()) != m_name) continue;
+        m_sysfs   = dir.filePath(entry);
+        m_devnode = "/dev/" + entry;
+        return true;
+    }
+    return false;
+}
+
+bool IioSensor::open()
+{
+    if (isOpen()) return true;
+    if (m_retryMs > 0 && !m_sinceFail.hasExpired(m_retryMs)) return false;
+
+    if (!findDevice()) {
+        // 只在第一次失败时报告，退避期间不刷日志
+        if (m_retryMs == 0) qWarning() << "IIO device" << m_name << "not found";
+        m_retryMs = qBound(SENSOR_RETRY_MIN_MS, m_retryMs * 2, SENSOR_RETRY_MAX_MS);
+        m_sinceFail.start();
+        return false;
+    }
+    bool ok = false;
+    m_scale = attr("in_" + m_channel + "_scale").toDouble(&ok);
+    if (!ok) m_scale = 1;
+    m_offset = attr("in_" + m_channel + "_offset").toDouble(&ok);
+    if (!ok) m_offset = 0;
+
+    if (setupBuffer()) {
+        m_fd = ::open(QFile::encodeName(m_devnode).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (m_fd >= 0) {
+            m_buffered = true;
+            m_retryMs = 0;
+            qDebug() << "IIO" << m_name << m_channel << "buffered," << m_scanBytes << "bytes/scan";
+            return true;
+        }
+        qWarning() << "open" << m_devnode << "failed:" << strerror(errno);
+        restoreBuffer();
+    }
+
+    // 没有缓冲支持：常开 raw 属性文件，每次从头 pread
+    m_buffered = false;
+    QString raw = m_sysfs + "/in_" + m_channel + "_raw";
+    m_fd = ::open(QFile::encodeName(raw).constData(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) {
+        if (m_retryMs == 0) qWarning() << "open" << raw << "failed:" << strerror(errno);
+        m_retryMs = qBound(SENSOR_RETRY_MIN_MS, m_retryMs * 2, SENSOR_RETRY_MAX_MS);
+        m_sinceFail.start();
+        return false;
+    }
+    m_retryMs = 0;
+    qDebug() << "IIO" << m_name << m_channel << "direct mode";
+    return true;
+}
+
+void IioSensor::close()
+{
+    if (m_fd < 0) return;
+    if (m_buffered) restoreBuffer();
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+bool IioSensor::setupBuffer()
+{
+    if (!QFileInfo(m_sysfs + "/scan_elements").isDir()) return false;
+
+    // 扫描元素与触发器只能在缓冲关闭时修改
+    setAttr("buffer/enable", "0");
+    m_savedValueEn     = attr("scan_elements/in_" + m_channel + "_en");
+    m_savedTimestampEn = attr("scan_elements/in_timestamp_en");
+    m_savedTrigger     = attr("trigger/current_trigger");
+    m_saved = true;
+
+    bool ok = setAttr("scan_elements/in_" + m_channel + "_en", "1") &&
+              setAttr("scan_elements/in_timestamp_en", "1");
+    if (ok) {
+        // 时间戳与其它模块统一用 CLOCK_MONOTONIC；老内核没有这个属性，只能换算
+        m_realtimeStamps = !setAttr("current_timestamp_clock", "monotonic");
+        ok = findTrigger() && readLayout();
+    }
+    if (ok) {
+        setAttr("buffer/length", QByteArray::number(IIO_BUFFER_LENGTH));
+        m_buf.resize(m_scanBytes * IIO_BUFFER_LENGTH);
+        ok = setAttr("buffer/enable", "1");
+    }
+    if (!ok) restoreBuffer();
+    return ok;
+}
+
+void IioSensor::restoreBuffer()
+{
+    setAttr("buffer/enable", "0");
+    if (!m_saved) return;
+    if (!m_savedValueEn.isEmpty()) setAttr("scan_elements/in_" + m_channel + "_en", m_savedValueEn);
+    if (!m_savedTimestampEn.isEmpty()) setAttr("scan_elements/in_timestamp_en", m_savedTimestampEn);
+    // 写入空行解除触发器
+    setAttr("trigger/current_trigger", m_savedTrigger.isEmpty() ? QByteArray("\n") : m_savedTrigger);
+    m_saved = false;
+}
+
+bool IioSensor::findTrigger()
+{
+    QByteArray want = qgetenv("IIO_TRIGGER");
+    if (want.isEmpty()) {
+        if (!attr("trigger/current_trigger").isEmpty()) return true;
+        // 设备自带的数据就绪触发器一般命名为 <name>-devN
+        QDir dir(IIO_SYSFS);
+        for (const QString &entry : dir.entryList(QStringList("trigger*"))) {
+            QFile file(dir.filePath(entry) + "/name");
+            if (!file.open(QIODevice::ReadOnly)) continue;
+            QByteArray name = file.readAll().trimmed();
+            if (name.startsWith(m_name.toLatin1())) {
+                want = name;
+                break;
+            }
+        }
+    }
+    if (want.isEmpty()) return false;
+    return setAttr("trigger/current_trigger", want);
+}
+
+bool IioSensor::readLayout()
+{
+    // 按 index 排列所有已启用的元素，每个元素按自身存储大小对齐
+    QVector<ScanElement> elements;
+    int valueIndex = -1, timestampIndex = -1;
+    QDir dir(m_sysfs + "/scan_elements");
+    for (const QString &en : dir.entryList(QStringList("*_en"))) {
+        if (attr("scan_elements/" + en) != "1") continue;
+        QString base = en.left(en.size() - 3);
+
+        ScanElement element;
+        bool ok = false;
+        element.index = attr("scan_elements/" + base + "_index").toInt(&ok);
+        if (!ok) return false;
+        // 形如 le:u16/16>>0
+        QByteArray type = attr("scan_elements/" + base + "_type");
+        char endian = 0, sign = 0;
+        unsigned bits = 0, storage = 0, shift = 0;
+        if (sscanf(type.constData(), "%ce:%c%u/%u>>%u", &endian, &sign, &bits, &storage, &shift) < 4 ||
+            storage == 0 || storage % 8 != 0 || storage > 64 ||
+            bits == 0 || bits > storage || shift >= storage) {
+            qWarning() << "unsupported IIO scan type" << type;
+            return false;
+        }
+        element.bigEndian = endian == 'b';
+        element.isSigned  = sign == 's';
+        element.bits      = bits;
+        element.bytes     = storage / 8;
+        element.shift     = shift;
+        if (base == "in_" + m_channel) valueIndex = element.index;
+        if (base == "in_timestamp")    timestampIndex = element.index;
+        elements.append(element);
+    }
+    if (valueIndex < 0 || timestampIndex < 0) return false;
+
+    std::sort(elements.begin(), elements.end(),
+              [](const ScanElement &a, const ScanElement &b) { return a.index < b.index; });
+    int offset = 0, align = 1;
+    for (ScanElement &element : elements) {
+        offset = (offset + element.bytes - 1) / element.bytes * element.bytes;
+        element.offset = offset;
+        offset += element.bytes;
+        align = qMax(align, element.bytes);
+        if (element.index == valueIndex)     m_value = element;
+        if (element.index == timestampIndex) m_timestamp = element;
+    }
+    m_scanBytes = (offset + align - 1) / align * align;
+    return true;
+}
+
+qint64 IioSensor::extract(const unsigned char *scan, const ScanElement &element) const
+{
+    const unsigned char *p = scan + element.offset;
+    quint64 raw = 0;
+    for (int i = 0; i < element.bytes; ++i) {
+        raw = (raw << 8) | p[element.bigEndian ? i : element.bytes - 1 - i];
+    }
+    raw >>= element.shift;
+    if (element.bits < 64) {
+        raw &= (1ULL << element.bits) - 1;
+        if (element.isSigned && (raw >> (element.bits - 1)) & 1) raw |= ~0ULL << element.bits;
+    }
+    return (qint64)raw;
+}
+
+int IioSensor::read(QVector<IioSample> *samples)
+{
+    if (m_fd < 0) return -1;
+
+    if (!m_buffered) {
+        char text[32];
+        ssize_t n = ::pread(m_fd, text, sizeof(text) - 1, 0);
+        if (n <= 0) return -1;
+        text[n] = 0;
+        IioSample sample;
+        sample.timestampUs = monotonicUs();
+        sample.value       = (strtoll(text, nullptr, 10) + m_offset) * m_scale;
+        samples->append(sample);
+        return 1;
+    }
+
+    // 一次取回内核缓冲区里已有的全部扫描
+    ssize_t n = ::read(m_fd, m_buf.data(), m_buf.size());
+    if (n < 0) return errno == EAGAIN ? 0 : -1;
+
+    qint64 shiftUs = 0;
+    if (m_realtimeStamps) {
+        struct timespec rt;
+        clock_gettime(CLOCK_REALTIME, &rt);
+        shiftUs = (qint64)rt.tv_sec * 1000000 + rt.tv_nsec / 1000 - monotonicUs();
+    }
+    const unsigned char *data = (const unsigned char*)m_buf.constData();
+    int count = (int)(n / m_scanBytes);
+    for (int i = 0; i < count; ++i) {
+        const unsigned char *scan = data + i * m_scanBytes;
+        IioSample sample;
+        sample.timestampUs = extract(scan, m_timestamp) / 1000 - shiftUs;
+        sample.value       = (extract(scan, m_value) + m_offset) * m_scale;
+        samples->append(sample);
+    }
+    return count;
+}
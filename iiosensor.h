@@ -0,0 +1,90 @@
+// iiosensor.h
+#ifndef IIOSENSOR_H
+#define IIOSENSOR_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+// 缓冲模式下内核缓冲区可容纳的扫描数
+#define IIO_BUFFER_LENGTH 128
+
+// 一个带时间戳的样本，值已按 scale/offset 换算（照度为 lux，电压为 mV）
+struct IioSample {
+    qint64  timestampUs = 0;    // CLOCK_MONOTONIC
+    double  value       = 0;
+};
+
+/**
+ * @brief IioSensor
+ * Linux IIO 采集后端：按名称（/sys/bus/iio/devices/iio:deviceN/name）找到设备，
+ * 启用一个通道加时间戳的触发缓冲，从 /dev/iio:deviceN 一次 read() 取回
+ * 触发器产生的全部扫描，时间戳由内核在触发时打上。
+ *
+ * 设备没有缓冲支持或找不到可用触发器（如主线 bh1750 驱动只有直接模式）时，
+ * 退回常开的 in_<channel>_raw 文件逐次 pread，接口不变。
+ * 触发器可用环境变量 IIO_TRIGGER 指定，否则沿用已设置的或找同名设备的触发器。
+ * 缓冲配置失败或关闭时，sysfs 里的通道使能与触发器恢复成打开前的值。
+ * 设备找不到或打不开时与 SensorHandle 一样按指数退避重试（SENSOR_RETRY_MIN_MS 起）。
+ */
+class IioSensor
+{
+public:
+    IioSensor(const QString &deviceName, const QString &channel);
+    ~IioSensor();
+
+    // 退避期间直接返回 false，不访问 sysfs
+    bool open();
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+    bool isBuffered() const { return m_buffered; }
+
+    // 把当前已就绪的样本追加到 samples，返回追加个数，出错返回 -1；
+    // 缓冲模式下没有新样本时返回 0，不阻塞
+    int read(QVector<IioSample> *samples);
+
+private:
+    // 缓冲扫描中一个元素的布局
+    struct ScanElement {
+        int   index   = 0;
+        int   offset  = 0;
+        int   bytes   = 0;
+        int   bits    = 0;
+        int   shift   = 0;
+        bool  isSigned  = false;
+        bool  bigEndian = false;
+    };
+
+    bool findDevice();
+    bool setupBuffer();
+    void restoreBuffer();
+    bool readLayout();
+    bool findTrigger();
+    qint64 extract(const unsigned char *scan, const ScanElement &element) const;
+    QByteArray attr(const QString &name) const;
+    bool setAttr(const QString &name, const QByteArray &value) const;
+
+    QString     m_name;
+    QString     m_channel;
+    QString     m_sysfs;            // /sys/bus/iio/devices/iio:deviceN
+    QString     m_devnode;          // /dev/iio:deviceN
+    int         m_fd = -1;
+    bool        m_buffered = false;
+    bool        m_realtimeStamps = false;   // 内核不支持切换时间戳时钟
+    double      m_scale  = 1;
+    double      m_offset = 0;
+    int         m_scanBytes = 0;
+    ScanElement m_value;
+    ScanElement m_timestamp;
+    QByteArray  m_buf;
+    // setupBuffer 之前的 sysfs 设置，缓冲关闭时写回
+    bool        m_saved = false;
+    QByteArray  m_savedValueEn;
+    QByteArray  m_savedTimestampEn;
+    QByteArray  m_savedTrigger;
+    int           m_retryMs = 0;        // 0 表示可以立即尝试
+    QElapsedTimer m_sinceFail;
+};
+
+#endif // IIOSENSOR_H
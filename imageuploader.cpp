@@ -1,5 +1,6 @@
 #include "imageuploader.h"
 #include "serialcomm.h"
+#include "roicrop.h"
 #include <QBuffer>
 #include <QThread>
 #include <QEventLoop>
@@ -140,16 +141,46 @@ void ImageUploader::checkNetworkAndUpload(const QImage &image)
     }
 }
 
+void ImageUploader::checkNetworkAndUpload(const QByteArray &jpeg)
+{
+    // 先裁剪再连网络，裁剪失败或不值得时原样上传
+    QByteArray payload = m_cropToSample ? cropJpegToSample(jpeg) : jpeg;
+    if (payload.size() != jpeg.size()) {
+        qDebug() << "[ImageUploader] 裁剪到样品区域:" << jpeg.size() << "->" << payload.size() << "bytes";
+    }
+    if (!ensureConnection()) return;
+    if (!uploadJpeg(payload)) {
+        emit errorOccurred(tr("图像上传失败"));
+    }
+}
+
 bool ImageUploader::uploadImage(const QImage &image)
 {
     if (!m_serial || !m_serial->isOpen() || image.isNull())
         return false;
 
+    // 只编码样品所在区域，托盘和背景不占串口带宽
+    QImage sample = image;
+    if (m_cropToSample) {
+        QRect roi = detectSampleRoi(image);
+        if (roi != image.rect()) {
+            qDebug() << "[ImageUploader] 裁剪到样品区域:" << roi;
+            sample = image.copy(roi);
+        }
+    }
+
     // 压缩 JPEG
     QByteArray imageData;
     QBuffer buf(&imageData);
     buf.open(QIODevice::WriteOnly);
-    image.save(&buf, "JPG", 50);
+    sample.save(&buf, "JPG", 50);
+    return uploadJpeg(imageData);
+}
+
+bool ImageUploader::uploadJpeg(const QByteArray &imageData)
+{
+    if (!m_serial || !m_serial->isOpen() || imageData.isEmpty())
+        return false;
 
     // 构造 multipart body
     QString boundary = "----WebKitFormBoundaryQtEsp8266";
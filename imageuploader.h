@@ -22,6 +22,10 @@ public:
 
     /// 启动连接并上传图片
     void checkNetworkAndUpload(const QImage &image);
+    /// 启动连接并直接上传已压缩的 JPEG 码流（如摄像头 MJPEG 帧），不再重新编码
+    void checkNetworkAndUpload(const QByteArray &jpeg);
+    /// 上传前自动裁剪到样品区域（默认开启）；串口透传很慢，字节数减半上传时间也减半
+    void setCropToSample(bool crop) { m_cropToSample = crop; }
 
 signals:
     /// 网络或上传出错
@@ -32,6 +36,7 @@ signals:
 private:
     bool ensureConnection();
     bool uploadImage(const QImage &image);
+    bool uploadJpeg(const QByteArray &imageData);
     void connectSignals();
 
     SerialComm *m_serial;
@@ -40,6 +45,7 @@ private:
     QString      m_ssid;
     QString      m_password;
     QByteArray  *m_responseBuffer;
+    bool         m_cropToSample = true;
 };
 
 #endif // IMAGEUPLOADER_H
@@ -0,0 +1,330 @@
+// jpegcrop.cpp
+
+#include "jpegcrop.h"
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+
+// 规范 Huffman 表：解码用 maxcode/valptr（JPEG 规范 F.2.2.3），编码用 ehufco/ehufsi（C.2）
+struct HuffTable {
+    bool     present = false;
+    uint8_t  vals[256];
+    int      mincode[17];
+    int      maxcode[18];
+    int      valptr[17];
+    uint16_t ehufco[256];
+    uint8_t  ehufsi[256];       // 0 表示该符号不在表里
+};
+
+bool buildTable(HuffTable *t, const uint8_t *bits, const uint8_t *vals, int nvals)
+{
+    memcpy(t->vals, vals, nvals);
+    memset(t->ehufsi, 0, sizeof(t->ehufsi));
+    int code = 0, k = 0;
+    for (int l = 1; l <= 16; ++l) {
+        t->valptr[l]  = k;
+        t->mincode[l] = code;
+        for (int i = 0; i < bits[l - 1]; ++i, ++k, ++code) {
+            t->ehufco[vals[k]] = (uint16_t)code;
+            t->ehufsi[vals[k]] = (uint8_t)l;
+        }
+        t->maxcode[l] = bits[l - 1] ? code - 1 : -1;
+        // 码字超出 l 位说明计数表不合法
+        if (code > (1 << l)) return false;
+        code <<= 1;
+    }
+    t->maxcode[17] = 0x7fffffff;
+    t->present = true;
+    return true;
+}
+
+// 熵编码数据的读取：去掉 0xFF00 填充，遇到标记后补 0
+struct BitReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t       acc = 0;
+    int            bits = 0;
+    bool           marker = false;
+
+    void fill()
+    {
+        while (bits <= 56) {
+            uint8_t byte = 0;
+            if (!marker && p < end) {
+                if (*p == 0xff) {
+                    if (p + 1 < end && p[1] == 0x00) {
+                        byte = 0xff;
+                        p += 2;
+                    } else {
+                        marker = true;
+                    }
+                } else {
+                    byte = *p++;
+                }
+            }
+            acc = (acc << 8) | byte;
+            bits += 8;
+        }
+    }
+    int get(int n)
+    {
+        if (n == 0) return 0;
+        if (bits < n) fill();
+        bits -= n;
+        return (int)((acc >> bits) & ((1u << n) - 1));
+    }
+    // 重启标记：丢掉字节对齐的填充位，跳过 RSTn，没有时返回 false
+    bool restart()
+    {
+        acc = 0;
+        bits = 0;
+        marker = false;
+        if (p + 1 < end && p[0] == 0xff && p[1] >= 0xd0 && p[1] <= 0xd7) {
+            p += 2;
+            return true;
+        }
+        return false;
+    }
+};
+
+int decodeSymbol(BitReader &in, const HuffTable &t)
+{
+    int code = in.get(1);
+    int l = 1;
+    while (code > t.maxcode[l]) {
+        if (++l > 16) return -1;
+        code = (code << 1) | in.get(1);
+    }
+    return t.vals[t.valptr[l] + code - t.mincode[l]];
+}
+
+// 熵编码数据的写入：0xFF 后补 0x00，结束时以 1 填满最后一个字节
+struct BitWriter {
+    std::vector<unsigned char> *out;
+    uint32_t acc = 0;
+    int      bits = 0;
+
+    void put(uint32_t value, int n)
+    {
+        if (n == 0) return;
+        acc = (acc << n) | (value & ((1u << n) - 1));
+        bits += n;
+        while (bits >= 8) {
+            bits -= 8;
+            uint8_t byte = (uint8_t)(acc >> bits);
+            out->push_back(byte);
+            if (byte == 0xff) out->push_back(0x00);
+        }
+    }
+    void flush()
+    {
+        if (bits > 0) put(0x7f, 8 - bits);
+    }
+};
+
+struct Component {
+    int id = 0;
+    int h = 1;
+    int v = 1;
+    int dc = 0;                 // 所用 Huffman 表号
+    int ac = 0;
+};
+
+int readU16(const uint8_t *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+int bitLength(int v)
+{
+    int n = 0;
+    for (v = v < 0 ? -v : v; v; v >>= 1) ++n;
+    return n;
+}
+
+} // namespace
+
+bool jpegCropLossless(const unsigned char *jpeg, int size,
+                      int x, int y, int w, int h,
+                      std::vector<unsigned char> *out,
+                      int *outX, int *outY)
+{
+    if (size < 4 || jpeg[0] != 0xff || jpeg[1] != 0xd8) return false;
+
+    HuffTable dcTables[4], acTables[4];
+    Component comps[4];
+    int ncomps = 0, width = 0, height = 0, restartInterval = 0;
+    int sofPos = -1, scanPos = -1;
+    std::vector<unsigned char> header;      // SOI 到 SOS（含）之间要原样保留的段
+    header.push_back(0xff);
+    header.push_back(0xd8);
+
+    // 1. 解析扫描之前的各段
+    int pos = 2;
+    while (scanPos < 0) {
+        if (pos + 4 > size || jpeg[pos] != 0xff) return false;
+        uint8_t marker = jpeg[pos + 1];
+        if (marker == 0xff) {           // 段之间允许的填充字节
+            ++pos;
+            continue;
+        }
+        int len = readU16(jpeg + pos + 2);
+        if (len < 2 || pos + 2 + len > size) return false;
+        const uint8_t *seg = jpeg + pos + 4;
+        int segLen = len - 2;
+
+        switch (marker) {
+        case 0xc0:                      // 基线 / 扩展顺序，Huffman 编码
+        case 0xc1: {
+            if (segLen < 6 || seg[0] != 8) return false;
+            height = readU16(seg + 1);
+            width  = readU16(seg + 3);
+            ncomps = seg[5];
+            if (width == 0 || height == 0 || ncomps < 1 || ncomps > 4 || segLen < 6 + ncomps * 3) {
+                return false;
+            }
+            for (int i = 0; i < ncomps; ++i) {
+                comps[i].id = seg[6 + i * 3];
+                comps[i].h  = seg[7 + i * 3] >> 4;
+                comps[i].v  = seg[7 + i * 3] & 15;
+                if (comps[i].h < 1 || comps[i].h > 4 || comps[i].v < 1 || comps[i].v > 4) return false;
+            }
+            // 单分量扫描不交织，每个 MCU 就是一个块
+            if (ncomps == 1) comps[0].h = comps[0].v = 1;
+            sofPos = (int)header.size();
+            break;
+        }
+        case 0xc4: {
+            int i = 0;
+            while (i + 17 <= segLen) {
+                int tc = seg[i] >> 4, th = seg[i] & 15;
+                int n = 0;
+                for (int k = 0; k < 16; ++k) n += seg[i + 1 + k];
+                if (tc > 1 || th > 3 || n > 256 || i + 17 + n > segLen) return false;
+                HuffTable *t = tc ? &acTables[th] : &dcTables[th];
+                if (!buildTable(t, seg + i + 1, seg + i + 17, n)) return false;
+                i += 17 + n;
+            }
+            break;
+        }
+        case 0xdd:
+            if (segLen < 2) return false;
+            restartInterval = readU16(seg);
+            pos += 2 + len;
+            continue;                   // 输出不带重启标记
+        case 0xda: {
+            if (sofPos < 0 || segLen < 1) return false;
+            int ns = seg[0];
+            if (ns != ncomps || segLen < 1 + ns * 2 + 3) return false;
+            for (int i = 0; i < ns; ++i) {
+                // 扫描里的分量顺序须与帧头一致
+                if (seg[1 + i * 2] != comps[i].id) return false;
+                comps[i].dc = seg[2 + i * 2] >> 4;
+                comps[i].ac = seg[2 + i * 2] & 15;
+                if (comps[i].dc > 3 || comps[i].ac > 3 ||
+                    !dcTables[comps[i].dc].present || !acTables[comps[i].ac].present) {
+                    return false;
+                }
+            }
+            const uint8_t *ss = seg + 1 + ns * 2;
+            if (ss[0] != 0 || ss[1] != 63 || ss[2] != 0) return false;
+            scanPos = pos + 2 + len;
+            break;
+        }
+        default:
+            // 渐进式、无损、算术编码等
+            if ((marker >= 0xc2 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) ||
+                marker == 0xd9) {
+                return false;
+            }
+            break;
+        }
+        header.insert(header.end(), jpeg + pos, jpeg + pos + 2 + len);
+        pos += 2 + len;
+    }
+
+    // 2. 裁剪框对齐到 MCU
+    int hmax = 1, vmax = 1;
+    for (int i = 0; i < ncomps; ++i) {
+        if (comps[i].h > hmax) hmax = comps[i].h;
+        if (comps[i].v > vmax) vmax = comps[i].v;
+    }
+    int mcuW = 8 * hmax, mcuH = 8 * vmax;
+    int mcusX = (width + mcuW - 1) / mcuW, mcusY = (height + mcuH - 1) / mcuH;
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (w <= 0 || h <= 0 || x >= width || y >= height) return false;
+    int mx0 = x / mcuW, my0 = y / mcuH;
+    int mx1 = (x + w + mcuW - 1) / mcuW, my1 = (y + h + mcuH - 1) / mcuH;
+    if (mx1 > mcusX) mx1 = mcusX;
+    if (my1 > mcusY) my1 = mcusY;
+    int cropX = mx0 * mcuW, cropY = my0 * mcuH;
+    int cropW = (mx1 * mcuW < width  ? mx1 * mcuW : width)  - cropX;
+    int cropH = (my1 * mcuH < height ? my1 * mcuH : height) - cropY;
+
+    // 帧头里改写尺寸（段内偏移：标记 2 + 长度 2 + 精度 1）
+    header[sofPos + 5] = (unsigned char)(cropH >> 8);
+    header[sofPos + 6] = (unsigned char)(cropH & 0xff);
+    header[sofPos + 7] = (unsigned char)(cropW >> 8);
+    header[sofPos + 8] = (unsigned char)(cropW & 0xff);
+    out->clear();
+    out->reserve(size);
+    out->insert(out->end(), header.begin(), header.end());
+
+    // 3. 逐块解码符号；框内的块按新的 DC 预测重新编码，AC 符号用同一张表原样写回
+    BitReader in;
+    in.p   = jpeg + scanPos;
+    in.end = jpeg + size;
+    BitWriter bw;
+    bw.out = out;
+    int pred[4] = { 0, 0, 0, 0 }, outPred[4] = { 0, 0, 0, 0 };
+    for (int my = 0; my < my1; ++my) {
+        for (int mx = 0; mx < mcusX; ++mx) {
+            int index = my * mcusX + mx;
+            if (restartInterval > 0 && index > 0 && index % restartInterval == 0) {
+                if (!in.restart()) return false;
+                memset(pred, 0, sizeof(pred));
+            }
+            bool inside = my >= my0 && mx >= mx0 && mx < mx1;
+            for (int c = 0; c < ncomps; ++c) {
+                const HuffTable &dcT = dcTables[comps[c].dc];
+                const HuffTable &acT = acTables[comps[c].ac];
+                for (int b = 0; b < comps[c].h * comps[c].v; ++b) {
+                    int t = decodeSymbol(in, dcT);
+                    if (t < 0 || t > 11) return false;
+                    int diff = in.get(t);
+                    if (t && diff < (1 << (t - 1))) diff -= (1 << t) - 1;
+                    pred[c] += diff;
+                    if (inside) {
+                        int d = pred[c] - outPred[c];
+                        int s = bitLength(d);
+                        if (s > 11 || !dcT.ehufsi[s]) return false;
+                        bw.put(dcT.ehufco[s], dcT.ehufsi[s]);
+                        bw.put(d < 0 ? d - 1 : d, s);
+                        outPred[c] = pred[c];
+                    }
+                    for (int k = 1; k < 64; ) {
+                        int rs = decodeSymbol(in, acT);
+                        if (rs < 0) return false;
+                        int r = rs >> 4, s = rs & 15;
+                        int extra = in.get(s);
+                        if (inside) {
+                            bw.put(acT.ehufco[rs], acT.ehufsi[rs]);
+                            bw.put(extra, s);
+                        }
+                        if (s == 0 && r != 15) break;       // EOB
+                        k += r + 1;
+                        if (k > 64) return false;
+                    }
+                }
+            }
+        }
+    }
+    bw.flush();
+    out->push_back(0xff);
+    out->push_back(0xd9);
+    if (outX) *outX = cropX;
+    if (outY) *outY = cropY;
+    return true;
+}
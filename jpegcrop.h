@@ -0,0 +1,26 @@
+// jpegcrop.h
+#ifndef JPEGCROP_H
+#define JPEGCROP_H
+
+#include <vector>
+
+/**
+ * 基线 JPEG 在压缩域内的无损裁剪（与 jpegtran -crop 同一思路）。
+ *
+ * 裁剪框向外对齐到 MCU 边界（4:2:2 为 16x8，4:2:0 为 16x16），框内每个 8x8 块的
+ * DCT 系数原样保留，只按新的扫描顺序重算 DC 差分并重新做 Huffman 编码，
+ * 因此没有解码/重编码带来的画质损失，也不需要 IDCT。
+ * 只支持 8 位基线顺序编码、所有分量交织在同一个扫描里的码流（UVC 摄像头的
+ * MJPEG 都是这种）；渐进式、多扫描或缺少 Huffman 表时返回 false。
+ * 原码流中的重启间隔（DRI/RSTn）在输出里去掉。
+ *
+ * @param x, y, w, h  期望保留的区域（像素）
+ * @param out         输出完整的 JPEG 码流
+ * @param outX, outY  可选，对齐后实际裁剪区域左上角在原图中的坐标
+ */
+bool jpegCropLossless(const unsigned char *jpeg, int size,
+                      int x, int y, int w, int h,
+                      std::vector<unsigned char> *out,
+                      int *outX = nullptr, int *outY = nullptr);
+
+#endif // JPEGCROP_H
@@ -1,12 +1,29 @@
 #include "mainwindow.h"
+#include "yuvconvert.h"
+#include "sensorscheduler.h"
+#include "drivermanager.h"
 #include <QApplication>
+#include <string.h>
 
 
 int main(int argc, char *argv[])
 {
+    // --bench-yuv：只跑颜色转换基准测试，不启动界面
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bench-yuv") == 0) {
+            benchmarkYuyvConvert(640, 480, 300);
+            return 0;
+        }
+    }
+
     QApplication a(argc, argv);
+    // 传感器驱动在后台加载，界面照常启动
+    SensorScheduler::preloadDrivers();
     MainWindow w;
     w.show();
 
-    return a.exec();
+    int ret = a.exec();
+    // 在 MainWindow 停掉传感器线程之前收尾驱动加载，不把等待留给静态析构
+    DriverManager::instance().shutdown();
+    return ret;
 }
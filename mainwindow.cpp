@@ -6,6 +6,7 @@
 #include "visualizer.h"
 #include "imageuploader.h"
 #include "serialcomm.h"
+#include "monotonic.h"
 
 #include <QMessageBox>
 #include <QPixmap>
@@ -16,11 +17,20 @@
 #include <QJsonArray>
 #include <QtConcurrent/QtConcurrent>
 
+// 各消费方需要的帧率：帧环/运动检测不需要全帧率，微距小窗 15fps 足够
+#define RECOGNITION_FPS   10
+#define MACRO_PREVIEW_FPS 15
+// 读数标签的趋势提示：统计最近 10 分钟，每秒刷新
+#define TREND_WINDOW_MS   (10 * 60 * 1000)
+#define TREND_REFRESH_MS  1000
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , camThread(nullptr)
+    , m_sensors(new SensorScheduler(this))
     , dhtThread(nullptr)
+    , m_trendTimer(new QTimer(this))
     , m_serial(new SerialComm(this))
 {
     ui->setupUi(this);
@@ -33,8 +43,48 @@ MainWindow::MainWindow(QWidget *parent)
 
     // 启动摄像头线程
     camThread = new cameraThread(this);
-    connect(camThread, &cameraThread::imageReady,
-            this, &MainWindow::displayFrame);
+    // 全景摄像头在 DEV_NAME0 上时，再尝试打开 DEV_NAME1 上的微距摄像头同时采集
+    if (camThread->devicePath() == DEV_NAME0) {
+        CaptureConfig config = CaptureConfig::fromEnvironment();
+        config.device = DEV_NAME1;
+        macroThread = new cameraThread(config, this);
+        if (macroThread->devicePath().isEmpty()) {
+            delete macroThread;
+            macroThread = nullptr;
+        }
+    }
+    if (macroThread) {
+        // 双摄：两路预览按时间戳配对，微距画面以小窗叠加在全景画面上
+        m_pairer = new FramePairer(1000000 / (2 * MACRO_PREVIEW_FPS), this);
+        connect(camThread, &cameraThread::previewReady,
+                m_pairer, &FramePairer::postFirst, Qt::DirectConnection);
+        connect(macroThread, &cameraThread::previewReady,
+                m_pairer, &FramePairer::postSecond, Qt::DirectConnection);
+        connect(m_pairer, &FramePairer::pairAvailable,
+                this, &MainWindow::displayPair);
+        macroThread->setPreviewSize(ui->viewlabel->size() / 3);
+        macroThread->setConsumerRate(RatePreview, MACRO_PREVIEW_FPS);
+        // 配对需要两路都按帧率出预览，静止时也不能跳过
+        camThread->setSkipStillPreview(false);
+        macroThread->setSkipStillPreview(false);
+        macroThread->start();
+    } else {
+        // 预览帧经邮箱交给 GUI：只保留最新一帧，界面卡顿时旧帧直接丢弃
+        m_previewBox = new FrameMailbox(this);
+        connect(camThread, &cameraThread::previewReady,
+                m_previewBox, &FrameMailbox::post, Qt::DirectConnection);
+        connect(m_previewBox, &FrameMailbox::frameAvailable,
+                this, &MainWindow::displayFrame);
+    }
+    // AUTO_RECOGNITION=1：场景变化后重新静止时自动识别
+    m_autoRecognition = qgetenv("AUTO_RECOGNITION") == "1";
+    connect(camThread, &cameraThread::sceneStable,
+            this, &MainWindow::onSceneStable);
+    connect(camThread, &cameraThread::stillReady,
+            this, &MainWindow::onStillReady);
+    camThread->setPreviewSize(ui->viewlabel->size());
+    camThread->setConsumerRate(RateRecognition, RECOGNITION_FPS);
+    setPreviewVisible(true);
     camThread->start();
 
 //    // 启动 DHT11 温湿度线程
@@ -46,11 +96,28 @@ MainWindow::MainWindow(QWidget *parent)
 //            dhtThread, &QObject::deleteLater);
 //    dhtThread->start();
 
+    // 所有传感器由同一个调度线程按各自周期采样
+    connect(m_sensors, &SensorScheduler::tempHumDetected,
+            this, &MainWindow::onTempHumDetected);
+    connect(m_sensors, &SensorScheduler::gasWarning,
+            this, &MainWindow::onGasUpdate);
+    connect(m_sensors, &SensorScheduler::lightDetected,
+            this, &MainWindow::onLightDetected);
+    connect(m_sensors, &SensorScheduler::distanceWarning,
+            this, &MainWindow::onDistanceUpdate);
+
     // 初始 UI 状态
     ui->label_5->setText("0.0℃，0.0%");
     ui->label_6->setText("正常");
     ui->label_3->setText("0.0cm");
     ui->label_4->setText("0.0lux");
+
+    // 历史窗口的拷贝缓冲一次分配到位，之后刷新不再分配
+    int capacity = SensorHistory::channel(SensorHistory::Gas).capacity();
+    m_trendTimes.resize(capacity);
+    m_trendValues.resize(capacity);
+    connect(m_trendTimer, &QTimer::timeout, this, &MainWindow::updateTrends);
+    m_trendTimer->start(TREND_REFRESH_MS);
 }
 
 MainWindow::~MainWindow()
@@ -71,22 +138,55 @@ void MainWindow::onTempHumDetected(float temperature, float humidity)
 {
     ui->label_5->setText(
            QStringLiteral(" %1℃ %2%")
-               .arg(temperature)
-               .arg(humidity));
+               .arg(temperature, 0, 'f', 1)
+               .arg(humidity, 0, 'f', 1));
 }
 
-void MainWindow::displayFrame(const QImage &img)
+void MainWindow::displayFrame()
 {
+    QImage img;
+    FrameInfo info;
+    if (!m_previewBox->take(&img, &info)) return;
     if (img.isNull()) {
         qDebug() << "[MainWindow] Error: 接收到空图像";
         return;
     }
-    m_lastFrame = img.copy();
-    ui->viewlabel->setPixmap(
-        QPixmap::fromImage(
-            m_lastFrame.scaled(ui->viewlabel->size(),
-                               Qt::KeepAspectRatio,
-                               Qt::SmoothTransformation)));
+    // 预览帧已按控件尺寸生成，直接显示
+    ui->viewlabel->setFrame(img);
+    camThread->stats()->frameDisplayed(info);
+}
+
+void MainWindow::displayPair()
+{
+    FramePair pair;
+    if (!m_pairer->take(&pair)) return;
+
+    // 全景为底，微距叠在右下角；某一路停流时只显示另一路
+    if (pair.complete()) ui->viewlabel->setFrame(pair.image[0], pair.image[1]);
+    else ui->viewlabel->setFrame(pair.image[0].isNull() ? pair.image[1] : pair.image[0]);
+    if (!pair.image[0].isNull()) camThread->stats()->frameDisplayed(pair.info[0]);
+    if (!pair.image[1].isNull()) macroThread->stats()->frameDisplayed(pair.info[1]);
+}
+
+void MainWindow::setPreviewVisible(bool visible)
+{
+    camThread->setConsumerRate(RatePreview, visible ? DEFAULT_FPS : 0);
+    if (macroThread) macroThread->setConsumerRate(RatePreview, visible ? MACRO_PREVIEW_FPS : 0);
+    // 主界面隐藏时暂停采集，返回时恢复隐藏前的状态
+    if (!visible) {
+        m_resumeCapture = camThread->isCapturing();
+        setCapturing(false);
+    } else if (m_resumeCapture) {
+        m_resumeCapture = false;
+        setCapturing(true);
+    }
+}
+
+void MainWindow::setCapturing(bool on)
+{
+    // 两路摄像头总是同开同停
+    camThread->setCapturing(on);
+    if (macroThread) macroThread->setCapturing(on);
 }
 
 void MainWindow::on_viewButton_clicked()
@@ -97,38 +197,23 @@ void MainWindow::on_viewButton_clicked()
     connect(vis, &visualizer::returnToMainWindow, this, [this, vis]() {
         vis->close();
         show();
-        camThread->startCapture();
+        setPreviewVisible(true);
     });
+    setPreviewVisible(false);
     vis->show();
 }
 
 void MainWindow::on_startButton_clicked()
 {
-    camThread->startCapture();
-    auto thGas     = new DataProcessThread(BroadGas, this);
-    auto thLight   = new DataProcessThread(LightLevel, this);
-    auto thUltra   = new DataProcessThread(Ultrasonic, this);
-    // 启动按钮里
-    auto thTempHum = new DataProcessThread(TempHumidity, this);
-    thTempHum->start();
-    connect(thTempHum, &DataProcessThread::tempHumDetected,
-            this,      &MainWindow::onTempHumDetected);
-
-
-    connect(thGas, &DataProcessThread::gasWarning,
-            this, &MainWindow::onGasUpdate);
-    connect(thLight, &DataProcessThread::lightDetected,
-            this, &MainWindow::onLightDetected);
-    connect(thUltra, &DataProcessThread::distanceWarning,
-            this, &MainWindow::onDistanceUpdate);
-
+    setCapturing(!camThread->isCapturing());
+    // 传感器调度线程只启动一次，重复点击不再创建新线程
+    m_sensors->startSampling();
 }
 
 void MainWindow::onGasUpdate(int gasValue)
 {
     QString status = (gasValue == 0 ? "正常" : "异常");
     QString color  = (gasValue == 0 ? "green" : "red");
-    WarningGas(gasValue);
     ui->label_6->setStyleSheet(
         QString("QLabel{color:%1;}").arg(color));
     ui->label_6->setText(status);
@@ -144,6 +229,39 @@ void MainWindow::onLightDetected(const QString &info)
     ui->label_4->setText(info + " lux");
 }
 
+QString MainWindow::trendText(SensorHistory::Channel ch, const QString &unit)
+{
+    qint64 since = monotonicUs() - TREND_WINDOW_MS * 1000LL;
+    int n = SensorHistory::channel(ch).window(since, m_trendTimes.data(), m_trendValues.data(),
+                                              m_trendValues.size());
+    int minutes = TREND_WINDOW_MS / 60000;
+    if (n == 0) return tr("最近 %1 分钟无数据").arg(minutes);
+
+    float lo = m_trendValues[0], hi = m_trendValues[0];
+    double sum = 0;
+    for (int i = 0; i < n; ++i) {
+        lo = qMin(lo, m_trendValues[i]);
+        hi = qMax(hi, m_trendValues[i]);
+        sum += m_trendValues[i];
+    }
+    return tr("最近 %1 分钟：最低 %2%5，平均 %3%5，最高 %4%5")
+            .arg(minutes)
+            .arg(lo, 0, 'f', 1)
+            .arg(sum / n, 0, 'f', 1)
+            .arg(hi, 0, 'f', 1)
+            .arg(unit);
+}
+
+void MainWindow::updateTrends()
+{
+    ui->label_6->setToolTip(trendText(SensorHistory::Gas, QString()));
+    ui->label_3->setToolTip(trendText(SensorHistory::Distance, " cm"));
+    ui->label_4->setToolTip(trendText(SensorHistory::Light, " lux"));
+    // 温湿度共用一个标签
+    ui->label_5->setToolTip(trendText(SensorHistory::Temperature, "℃") + "\n" +
+                            trendText(SensorHistory::Humidity, "%"));
+}
+
 void MainWindow::on_saveButton_clicked()
 {
     QMessageBox::information(this, tr("提示"), tr("保存成功"));
@@ -159,9 +277,10 @@ void MainWindow::on_wifiButton_clicked()
             this, [this, w]() {
         w->close();
         show();
-        camThread->startCapture();
+        setPreviewVisible(true);
     });
     hide();
+    setPreviewVisible(false);
     w->show();
 }
 
@@ -178,28 +297,82 @@ void MainWindow::onServerConfigured(const QString &host,
 
 void MainWindow::on_recognitionButton_clicked()
 {
+    recognize(true);
+}
+
+void MainWindow::onSceneStable()
+{
+    // 样品放好并静止后自动识别一次；上一次识别仍在进行时跳过
+    if (!m_autoRecognition || m_recognizing) return;
+    if (m_serverHost.isEmpty() || m_serverPort.isEmpty()) return;
+    recognize(false);
+}
+
+void MainWindow::recognize(bool interactive)
+{
+    // 自动触发时不弹窗，只记录原因
+    auto fail = [this, interactive](bool critical, const QString &msg) {
+        if (!interactive) {
+            qDebug() << "[MainWindow] 自动识别跳过:" << msg;
+        } else if (critical) {
+            QMessageBox::critical(this, tr("错误"), msg);
+        } else {
+            QMessageBox::warning(this, tr("警告"), msg);
+        }
+    };
+
     // 1. 基础校验
     if (!m_serial) {
-        QMessageBox::critical(this, tr("错误"), tr("串口对象未初始化"));
+        fail(true, tr("串口对象未初始化"));
         return;
     }
-    if (m_lastFrame.isNull()) {
-        QMessageBox::warning(this, tr("警告"), tr("尚未获取到图像帧"));
+    // 设备有高分辨率静帧模式时现拍一张，否则从帧环里挑最近 2 秒内最清晰的一帧，
+    // 避免上传模糊图像白跑一趟慢速链路
+    bool still = camThread->hasStillMode();
+    RingFrame frame;
+    // 帧环为空（或已关闭）但仍在采集时，上传线程改为等下一帧快照
+    if (!still && !camThread->sharpestRecentFrame(&frame) && !camThread->isCapturing()) {
+        fail(false, tr("尚未获取到图像帧"));
         return;
     }
     if (m_serverHost.isEmpty() || m_serverPort.isEmpty()) {
-        QMessageBox::warning(this, tr("警告"), tr("请先通过 WiFi 设置服务器"));
+        fail(false, tr("请先通过 WiFi 设置服务器"));
         return;
     }
 
     // 2. 打开串口（如尚未打开）
     if (!m_serial->isOpen()) {
         if (!m_serial->openPort("/dev/ttymxc1", 115200)) {
-            QMessageBox::critical(this, tr("错误"), tr("打开串口失败"));
+            fail(true, tr("打开串口失败"));
             return;
         }
     }
 
+    m_recognizing = true;
+    if (still) {
+        m_stillPending = true;
+        camThread->requestStill();
+        return;
+    }
+    uploadFrame(frame);
+}
+
+void MainWindow::onStillReady(const RingFrame &frame)
+{
+    if (!m_stillPending) return;
+    m_stillPending = false;
+    // 静帧失败时退回帧环里的预览分辨率帧
+    RingFrame upload = frame;
+    if (upload.isNull() && !camThread->sharpestRecentFrame(&upload)) {
+        qDebug() << "[MainWindow] 静帧失败且帧环为空，放弃识别";
+        m_recognizing = false;
+        return;
+    }
+    uploadFrame(upload);
+}
+
+void MainWindow::uploadFrame(const RingFrame &frame)
+{
     // 3. 创建 uploader 并连接信号
     auto *uploader = new ImageUploader(
         m_serial,
@@ -232,18 +405,36 @@ void MainWindow::on_recognitionButton_clicked()
             }
             QMessageBox::information(this, tr("识别完成"), msg);
         }
+        m_recognizing = false;
         uploader->deleteLater();
     }, Qt::QueuedConnection);
 
     connect(uploader, &ImageUploader::errorOccurred,
             this, [this, uploader](const QString &err) {
         QMessageBox::critical(this, tr("错误"), err);
+        m_recognizing = false;
         uploader->deleteLater();
     }, Qt::QueuedConnection);
 
-    // 4. 异步执行上传和识别
-    QtConcurrent::run([uploader, this]() {
-        uploader->checkNetworkAndUpload(m_lastFrame);
+    // 4. 异步执行上传和识别；MJPEG 模式直接上传摄像头码流，省去 RGB 转换和重新编码，
+    //    原始格式在工作线程里转 RGB，帧按值捕获，不受采集线程后续写入影响
+    if (!frame.isNull()) {
+        qDebug() << "[MainWindow] 上传帧" << frame.info.sequence
+                 << frame.width << "x" << frame.height
+                 << "清晰度" << frame.focus << "，采集后"
+                 << (monotonicUs() - frame.info.timestampUs) / 1000 << "ms";
+    }
+    cameraThread *cam = camThread;
+    QtConcurrent::run([uploader, frame, cam]() {
+        if (frame.isNull()) {
+            // 帧环里没有帧时退而上传一张新的全分辨率帧
+            QImage img;
+            if (cam->snapshot(&img)) uploader->checkNetworkAndUpload(img);
+            else emit uploader->errorOccurred(MainWindow::tr("获取图像帧超时"));
+            return;
+        }
+        if (frame.isJpeg()) uploader->checkNetworkAndUpload(frame.data);
+        else                uploader->checkNetworkAndUpload(frame.toImage());
     });
 }
 
@@ -2,9 +2,14 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
+#include <QVector>
 #include "camerathread.h"
+#include "framemailbox.h"
+#include "framepairer.h"
 #include "dht11thread.h"
-#include "dataprocessthread.h"
+#include "sensorscheduler.h"
+#include "sensorhistory.h"
 #include "serialcomm.h"
 #include "imageuploader.h"
 
@@ -23,28 +28,49 @@ private slots:
 //    void updateDHT11Display(const QString &tempInt,
 //                            const QString &tempFrac,
 //                            const QString &humidity);
-    void displayFrame(const QImage &img);
+    void displayFrame();
+    void displayPair();
+    void onSceneStable();
+    void onStillReady(const RingFrame &frame);
     void on_viewButton_clicked();
     void on_startButton_clicked();
     void on_saveButton_clicked();
     void on_recognitionButton_clicked();
     void on_wifiButton_clicked();
 
-    // 来自 DataProcessThread
+    // 来自 SensorScheduler
     void onGasUpdate(int gasValue);
     void onDistanceUpdate(float dist);
     void onLightDetected(const QString &info);
     void onTempHumDetected(float temperature, float humidity);
+    // 按 SensorHistory 刷新各读数标签的趋势提示
+    void updateTrends();
 
     // 来自 NetConfigWidget
     void onServerConfigured(const QString &host, const QString &port);
 
 private:
+    void setCapturing(bool on);
+    void setPreviewVisible(bool visible);
+    void recognize(bool interactive);
+    void uploadFrame(const RingFrame &frame);
+    QString trendText(SensorHistory::Channel ch, const QString &unit);
+
     Ui::MainWindow *ui;
 
     cameraThread *camThread;
+    cameraThread *macroThread = nullptr;     // 第二路（微距）摄像头，未接时为空
+    FrameMailbox *m_previewBox = nullptr;
+    FramePairer  *m_pairer = nullptr;        // 双摄时代替 m_previewBox
+    bool          m_autoRecognition = false;
+    bool          m_recognizing = false;
+    bool          m_stillPending = false;    // 已请求高分辨率静帧，等待 stillReady
+    bool          m_resumeCapture = false;   // 主界面隐藏前正在采集，返回时恢复
+    SensorScheduler *m_sensors;
     DHT11Thread  *dhtThread;
-    QImage        m_lastFrame;
+    QTimer       *m_trendTimer;
+    QVector<qint64> m_trendTimes;            // 读取历史窗口用，构造时按环容量分配
+    QVector<float>  m_trendValues;
 
     QString       m_serverHost;
     QString       m_serverPort;
@@ -0,0 +1,11 @@
+// monotonic.cpp
+
+#include "monotonic.h"
+#include <time.h>
+
+qint64 monotonicUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (qint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -0,0 +1,11 @@
+// monotonic.h
+#ifndef MONOTONIC_H
+#define MONOTONIC_H
+
+#include <QtGlobal>
+
+// CLOCK_MONOTONIC 当前时间（微秒），与 V4L2 单调时间戳、IIO 缓冲时间戳同一时基；
+// 采集、传感器调度、统计各模块的时间戳都用它
+qint64 monotonicUs();
+
+#endif // MONOTONIC_H
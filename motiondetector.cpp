@@ -0,0 +1,67 @@
+// motiondetector.cpp
+
+#include "motiondetector.h"
+#include "yuvconvert.h"
+#include <string.h>
+
+MotionDetector::MotionDetector()
+{
+}
+
+void MotionDetector::reset()
+{
+    m_key.clear();
+    m_rowBytes    = 0;
+    m_rows        = 0;
+    m_stillFrames = 0;
+    m_state       = Unknown;
+    m_mad         = 0;
+}
+
+MotionDetector::Event MotionDetector::update(const unsigned char *y, int ystep, int stride,
+                                             int width, int height, bool *changed)
+{
+    int rowBytes = width * ystep;
+    int rows     = (height + MOTION_ROW_STEP - 1) / MOTION_ROW_STEP;
+
+    // 首帧或格式变化：只建立关键帧
+    if (rowBytes != m_rowBytes || rows != m_rows || m_key.empty()) {
+        reset();
+        m_rowBytes = rowBytes;
+        m_rows     = rows;
+        m_key.resize((size_t)rowBytes * rows);
+        for (int r = 0; r < rows; ++r) {
+            memcpy(&m_key[(size_t)r * rowBytes], y + (size_t)r * MOTION_ROW_STEP * stride, rowBytes);
+        }
+        *changed = true;
+        return NoEvent;
+    }
+
+    unsigned long long sad = 0;
+    for (int r = 0; r < rows; ++r) {
+        sad += luma_sad(y + (size_t)r * MOTION_ROW_STEP * stride,
+                        &m_key[(size_t)r * rowBytes], rowBytes, ystep);
+    }
+    m_mad = (double)sad / ((double)rows * width);
+
+    *changed = m_mad > MOTION_STILL_MAD;
+    if (*changed) {
+        for (int r = 0; r < rows; ++r) {
+            memcpy(&m_key[(size_t)r * rowBytes], y + (size_t)r * MOTION_ROW_STEP * stride, rowBytes);
+        }
+        m_stillFrames = 0;
+    } else {
+        m_stillFrames++;
+    }
+
+    if (m_mad > MOTION_CHANGE_MAD && m_state != Moving) {
+        m_state = Moving;
+        return SceneChanged;
+    }
+    if (m_stillFrames == MOTION_STABLE_FRAMES && m_state != Stable) {
+        bool wasMoving = m_state == Moving;
+        m_state = Stable;
+        if (wasMoving) return SceneStable;
+    }
+    return NoEvent;
+}
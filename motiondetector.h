@@ -0,0 +1,53 @@
+// motiondetector.h
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+#include <vector>
+
+// 每隔几行取一行参与比较：640x480 时约 120 行，足以发现放样和晃动
+#define MOTION_ROW_STEP      4
+// 阈值均为单个亮度样本的平均绝对差（0~255）
+#define MOTION_STILL_MAD     3.0    // 低于此值视为没有变化（覆盖传感器噪声）
+#define MOTION_CHANGE_MAD    8.0    // 高于此值视为场景变化
+#define MOTION_STABLE_FRAMES 15     // 连续无变化多少帧判定为稳定（30fps 约 0.5 秒）
+
+/**
+ * @brief MotionDetector
+ * 直接在采集缓冲区的 Y 分量上做帧差，在 RGB 转换之前运行。
+ *
+ * 与“关键帧”比较而不是与上一帧比较：只有差异超过 MOTION_STILL_MAD 时才把
+ * 当前帧记为新的关键帧，因此缓慢漂移也能累积出来，场景静止时也不必每帧拷贝。
+ * 只在状态切换时返回事件：静止->变化返回 SceneChanged，变化后重新静止
+ * MOTION_STABLE_FRAMES 帧返回 SceneStable（启动时的首次静止不算）。
+ */
+class MotionDetector
+{
+public:
+    enum Event { NoEvent, SceneChanged, SceneStable };
+
+    MotionDetector();
+
+    /**
+     * @param y       第一个 Y 样本
+     * @param ystep   相邻 Y 样本的字节间隔（YUYV 为 2，NV12 为 1）
+     * @param changed 输出：与关键帧相比是否有可见变化
+     */
+    Event update(const unsigned char *y, int ystep, int stride,
+                 int width, int height, bool *changed);
+
+    // 最近一帧与关键帧的平均绝对差
+    double lastDifference() const { return m_mad; }
+    void reset();
+
+private:
+    enum State { Unknown, Moving, Stable };
+
+    std::vector<unsigned char> m_key;     // 关键帧的采样行，逐行紧密排列
+    int    m_rowBytes = 0;
+    int    m_rows = 0;
+    int    m_stillFrames = 0;
+    State  m_state = Unknown;
+    double m_mad = 0;
+};
+
+#endif // MOTIONDETECTOR_H
@@ -0,0 +1,122 @@
+// rangefilter.cpp
+#include "rangefilter.h"
+
+// 卡尔曼参数（回波时间域）：测量噪声约 ±0.5cm，目标加速度约 1m/s²
+#define RANGE_MEASURE_SIGMA_US  30.0
+#define RANGE_ACCEL_SIGMA_US    6000.0
+// 超过这么久没有有效回波就重新开始
+#define RANGE_STALE_US          500000
+
+void StreamingMedian::reset()
+{
+    m_count = 0;
+    m_head  = 0;
+}
+
+double StreamingMedian::push(double value)
+{
+    // 窗口满时先从有序副本里删掉最旧的样本
+    int n = m_count;
+    if (n == RANGE_MEDIAN_WINDOW) {
+        double oldest = m_ring[m_head];
+        int i = 0;
+        while (m_sorted[i] != oldest) ++i;
+        for (; i < n - 1; ++i) m_sorted[i] = m_sorted[i + 1];
+        --n;
+    }
+    m_ring[m_head] = value;
+    m_head = (m_head + 1) % RANGE_MEDIAN_WINDOW;
+
+    // 插入排序位置
+    int i = n;
+    while (i > 0 && m_sorted[i - 1] > value) {
+        m_sorted[i] = m_sorted[i - 1];
+        --i;
+    }
+    m_sorted[i] = value;
+    m_count = n + 1;
+
+    if (m_count & 1) return m_sorted[m_count / 2];
+    return (m_sorted[m_count / 2 - 1] + m_sorted[m_count / 2]) / 2;
+}
+
+RangeKalman::RangeKalman(double accelNoise, double measureNoise)
+    : m_q(accelNoise * accelNoise)
+    , m_r(measureNoise * measureNoise)
+{
+}
+
+void RangeKalman::predict(double dt)
+{
+    if (!m_initialized) return;
+    // x = F x，P = F P F' + Q，F = [1 dt; 0 1]
+    m_x[0] += m_x[1] * dt;
+    double p00 = m_p[0][0] + dt * (m_p[1][0] + m_p[0][1]) + dt * dt * m_p[1][1];
+    double p01 = m_p[0][1] + dt * m_p[1][1];
+    double p10 = m_p[1][0] + dt * m_p[1][1];
+    double p11 = m_p[1][1];
+    double dt2 = dt * dt;
+    m_p[0][0] = p00 + m_q * dt2 * dt2 / 4;
+    m_p[0][1] = p01 + m_q * dt2 * dt / 2;
+    m_p[1][0] = p10 + m_q * dt2 * dt / 2;
+    m_p[1][1] = p11 + m_q * dt2;
+}
+
+double RangeKalman::update(double z, double dt)
+{
+    if (!m_initialized) {
+        m_x[0] = z;
+        m_x[1] = 0;
+        m_p[0][0] = m_r;
+        m_p[0][1] = m_p[1][0] = 0;
+        m_p[1][1] = m_q;
+        m_initialized = true;
+        return z;
+    }
+    predict(dt);
+    // 只观测位置：H = [1 0]
+    double s  = m_p[0][0] + m_r;
+    double k0 = m_p[0][0] / s;
+    double k1 = m_p[1][0] / s;
+    double y  = z - m_x[0];
+    m_x[0] += k0 * y;
+    m_x[1] += k1 * y;
+    double p00 = m_p[0][0], p01 = m_p[0][1];
+    m_p[0][0] -= k0 * p00;
+    m_p[0][1] -= k0 * p01;
+    m_p[1][0] -= k1 * p00;
+    m_p[1][1] -= k1 * p01;
+    return m_x[0];
+}
+
+RangeFilter::RangeFilter()
+    : m_kalman(RANGE_ACCEL_SIGMA_US, RANGE_MEASURE_SIGMA_US)
+{
+}
+
+void RangeFilter::reset()
+{
+    m_median.reset();
+    m_kalman.reset();
+    m_validUs = 0;
+}
+
+double RangeFilter::distance() const
+{
+    // 估计落到 0 以下说明滤波器还没收敛，当作没有有效值
+    if (!m_kalman.isInitialized() || m_kalman.position() <= 0) return -1;
+    return m_kalman.position() * ECHO_US_TO_CM;
+}
+
+double RangeFilter::push(qint64 echoUs, qint64 timestampUs)
+{
+    if (echoUs <= 0 || echoUs > RANGE_MAX_ECHO_US) {
+        if (m_validUs && timestampUs - m_validUs > RANGE_STALE_US) reset();
+        return distance();
+    }
+    // 丢失期间没有预测，这里一次预测过整段间隔
+    double dt = m_validUs ? (timestampUs - m_validUs) / 1e6 : 0;
+    m_validUs = timestampUs;
+    m_kalman.update(m_median.push((double)echoUs), dt);
+    return distance();
+}
@@ -0,0 +1,83 @@
+// rangefilter.h
+#ifndef RANGEFILTER_H
+#define RANGEFILTER_H
+
+#include <QtGlobal>
+
+// 中值窗口（奇数）；5 个样本能去掉连续两次的多径/漏检尖峰
+#define RANGE_MEDIAN_WINDOW 5
+// HC-SR04 回波时间上限：超过约 4m（23.5ms）视为无回波
+#define RANGE_MAX_ECHO_US   23500
+// 回波时间（us）换算为距离（cm）：声速 340m/s，往返取一半
+#define ECHO_US_TO_CM       0.017
+
+/**
+ * 固定窗口的流式中值：环形缓冲记录到达顺序，另存一份有序副本，
+ * 每个新样本删一插一，耗时只与窗口大小有关，不分配内存。
+ */
+class StreamingMedian
+{
+public:
+    StreamingMedian() { reset(); }
+    void   reset();
+    // 加入一个样本并返回当前窗口的中值（窗口未满时取已有样本的中值）
+    double push(double value);
+
+private:
+    double m_ring[RANGE_MEDIAN_WINDOW];
+    double m_sorted[RANGE_MEDIAN_WINDOW];
+    int    m_count;
+    int    m_head;
+};
+
+/**
+ * 匀速模型的一维卡尔曼滤波（状态为位置与速度），按实际采样间隔预测。
+ * accelNoise 为加速度扰动的标准差，measureNoise 为测量标准差，单位与输入一致。
+ */
+class RangeKalman
+{
+public:
+    RangeKalman(double accelNoise, double measureNoise);
+    void   reset() { m_initialized = false; }
+    bool   isInitialized() const { return m_initialized; }
+    // 只预测 dt 秒（本次没有有效测量）
+    void   predict(double dt);
+    // 预测 dt 秒后用测量 z 修正，返回修正后的位置
+    double update(double z, double dt);
+    double position() const { return m_x[0]; }
+    double velocity() const { return m_x[1]; }
+
+private:
+    double m_q;
+    double m_r;
+    double m_x[2];
+    double m_p[2][2];
+    bool   m_initialized = false;
+};
+
+/**
+ * @brief RangeFilter
+ * 超声波回波时间的流式滤波：先中值去尖峰，再卡尔曼平滑，在回波时间域内
+ * 计算，最后换算为距离。无回波或超量程的样本保持上一次估计，不按速度外推
+ * （外推在丢失期间会一路冲到 0 或量程外）；回波恢复后按整段间隔预测再修正。
+ * 连续丢失太久则重置。
+ */
+class RangeFilter
+{
+public:
+    RangeFilter();
+    void reset();
+    // 送入一次测量（echoUs <= 0 表示无效），返回滤波后的距离（cm），还没有有效值时返回 -1
+    double push(qint64 echoUs, qint64 timestampUs);
+    // 最近一次有效测量的时刻，0 表示没有；等于本次时间戳说明本次回波有效
+    qint64 lastValidUs() const { return m_validUs; }
+
+private:
+    double distance() const;
+
+    StreamingMedian m_median;
+    RangeKalman     m_kalman;
+    qint64          m_validUs = 0;      // 最近一次有效测量的时刻
+};
+
+#endif // RANGEFILTER_H
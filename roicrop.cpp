@@ -0,0 +1,129 @@
+// roicrop.cpp
+
+#include "roicrop.h"
+#include "jpegcrop.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+#define ROI_GRID_W        80
+#define ROI_GRID_H        60
+#define ROI_BORDER        2       // 取四周几圈格子估计背景
+#define ROI_MIN_DIST      48      // 与背景的 RGB 色差（三通道绝对差之和）下限
+#define ROI_MAX_COVER     0.8     // 裁剪后面积超过原图此比例时不值得裁剪
+
+static int medianOf(std::vector<int> &v)
+{
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+static QRect detectOnGrid(const QImage &grid)
+{
+    const int w = grid.width(), h = grid.height();
+
+    // 1. 背景色：四周像素各通道的中位数；背景噪声：这些像素到中位色的平均距离
+    std::vector<int> rs, gs, bs;
+    for (int y = 0; y < h; ++y) {
+        const QRgb *line = (const QRgb*)grid.constScanLine(y);
+        for (int x = 0; x < w; ++x) {
+            if (x >= ROI_BORDER && x < w - ROI_BORDER && y >= ROI_BORDER && y < h - ROI_BORDER) continue;
+            rs.push_back(qRed(line[x]));
+            gs.push_back(qGreen(line[x]));
+            bs.push_back(qBlue(line[x]));
+        }
+    }
+    int mr = medianOf(rs), mg = medianOf(gs), mb = medianOf(bs);
+    auto dist = [=](QRgb p) {
+        return qAbs(qRed(p) - mr) + qAbs(qGreen(p) - mg) + qAbs(qBlue(p) - mb);
+    };
+    long long noise = 0;
+    int borderCount = 0;
+    for (int y = 0; y < h; ++y) {
+        const QRgb *line = (const QRgb*)grid.constScanLine(y);
+        for (int x = 0; x < w; ++x) {
+            if (x >= ROI_BORDER && x < w - ROI_BORDER && y >= ROI_BORDER && y < h - ROI_BORDER) continue;
+            noise += dist(line[x]);
+            borderCount++;
+        }
+    }
+    int threshold = qMax<int>(ROI_MIN_DIST, 3 * noise / qMax(borderCount, 1));
+
+    // 2. 前景格子按行、列计数；一行/列至少两个前景格才算，去掉孤立噪点
+    std::vector<int> rowCount(h, 0), colCount(w, 0);
+    int foreground = 0;
+    for (int y = 0; y < h; ++y) {
+        const QRgb *line = (const QRgb*)grid.constScanLine(y);
+        for (int x = 0; x < w; ++x) {
+            if (dist(line[x]) > threshold) {
+                rowCount[y]++;
+                colCount[x]++;
+                foreground++;
+            }
+        }
+    }
+    if (foreground < 4 || foreground > w * h * 85 / 100) return QRect();
+
+    int top = 0, bottom = h - 1, left = 0, right = w - 1;
+    while (top < h && rowCount[top] < 2) ++top;
+    while (bottom > top && rowCount[bottom] < 2) --bottom;
+    while (left < w && colCount[left] < 2) ++left;
+    while (right > left && colCount[right] < 2) --right;
+    if (top >= h || left >= w) return QRect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+// 网格坐标映射回原图，四周各留 10% 边距（至少一格）
+static QRect gridToImage(const QRect &box, const QSize &gridSize, const QSize &imageSize)
+{
+    if (box.isNull()) return QRect(QPoint(0, 0), imageSize);
+    int mx = qMax(1, box.width() / 10), my = qMax(1, box.height() / 10);
+    QRect padded = box.adjusted(-mx, -my, mx, my)
+                      .intersected(QRect(QPoint(0, 0), gridSize));
+    double sx = double(imageSize.width()) / gridSize.width();
+    double sy = double(imageSize.height()) / gridSize.height();
+    QRect roi(int(padded.left() * sx), int(padded.top() * sy),
+              int((padded.right() + 1) * sx) - int(padded.left() * sx),
+              int((padded.bottom() + 1) * sy) - int(padded.top() * sy));
+    roi = roi.intersected(QRect(QPoint(0, 0), imageSize));
+    // 裁不掉多少时保持原图
+    if (roi.width() * roi.height() > imageSize.width() * imageSize.height() * ROI_MAX_COVER) {
+        return QRect(QPoint(0, 0), imageSize);
+    }
+    return roi;
+}
+
+QRect detectSampleRoi(const QImage &image)
+{
+    if (image.isNull()) return QRect();
+    QImage grid = image.scaled(ROI_GRID_W, ROI_GRID_H, Qt::IgnoreAspectRatio, Qt::FastTransformation)
+                       .convertToFormat(QImage::Format_RGB32);
+    return gridToImage(detectOnGrid(grid), grid.size(), image.size());
+}
+
+QByteArray cropJpegToSample(const QByteArray &jpeg)
+{
+    QByteArray data = jpeg;     // QBuffer 需要非 const 数组，共享数据不拷贝
+    QBuffer probeBuf(&data);
+    QImageReader probe(&probeBuf, "JPG");
+    QSize full = probe.size();
+    if (!full.isValid()) return jpeg;
+    // 唯一的一次解码，按 DCT 缩放，代价远小于全尺寸解码
+    probe.setScaledSize(QSize(ROI_GRID_W, ROI_GRID_H));
+    QImage grid = probe.read().convertToFormat(QImage::Format_RGB32);
+    if (grid.isNull()) return jpeg;
+
+    QRect roi = gridToImage(detectOnGrid(grid), grid.size(), full);
+    if (roi == QRect(QPoint(0, 0), full)) return jpeg;
+
+    // 系数原样搬运，没有二次压缩损失；渐进式等不支持的码流原样上传
+    std::vector<unsigned char> out;
+    if (!jpegCropLossless((const unsigned char*)jpeg.constData(), jpeg.size(),
+                          roi.x(), roi.y(), roi.width(), roi.height(), &out)) {
+        qDebug() << "lossless crop unsupported for this JPEG, uploading uncropped";
+        return jpeg;
+    }
+    return QByteArray((const char*)out.data(), (int)out.size());
+}
@@ -0,0 +1,25 @@
+// roicrop.h
+#ifndef ROICROP_H
+#define ROICROP_H
+
+#include <QImage>
+#include <QRect>
+#include <QByteArray>
+
+/**
+ * 在缩小到 80x60 的图上找样品所在区域。
+ *
+ * 以画面四周一圈像素的中位色作为托盘/背景色，与之色差明显的格子视为前景，
+ * 取前景的外接框并留出边距。背景不均匀、前景几乎占满或几乎为空时返回
+ * image.rect()，即不裁剪。
+ */
+QRect detectSampleRoi(const QImage &image);
+
+/**
+ * 对 JPEG 码流做同样的检测：只按 DCT 缩放解码一次小图找区域，值得裁剪时
+ * 在压缩域内按 MCU 边界无损裁剪（见 jpegCropLossless），不解码全图也不重新编码；
+ * 不值得裁剪或码流不支持时原样返回。
+ */
+QByteArray cropJpegToSample(const QByteArray &jpeg);
+
+#endif // ROICROP_H
@@ -0,0 +1,87 @@
+// sensorhandle.cpp
+
+#include "sensorhandle.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+SensorHandle::SensorHandle(const char *path, int flags, Setup setup)
+    : m_path(path)
+    , m_flags(flags | O_CLOEXEC)
+    , m_setup(setup)
+{
+}
+
+SensorHandle::~SensorHandle()
+{
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+int SensorHandle::fd()
+{
+    if (m_fd >= 0) return m_fd;
+    if (m_retryMs > 0 && !m_sinceFail.hasExpired(m_retryMs)) return -1;
+
+    m_fd = ::open(m_path, m_flags);
+    if (m_fd >= 0 && m_setup && m_setup(m_fd) < 0) {
+        int err = errno;
+        ::close(m_fd);
+        m_fd = -1;
+        errno = err;
+    }
+    if (m_fd < 0) {
+        // 只在第一次失败时报告，退避期间不刷日志
+        if (m_retryMs == 0) qWarning() << "open" << m_path << "failed:" << strerror(errno);
+        m_retryMs = qBound(SENSOR_RETRY_MIN_MS, m_retryMs * 2, SENSOR_RETRY_MAX_MS);
+        m_sinceFail.start();
+        return -1;
+    }
+    if (m_retryMs > 0) qDebug() << m_path << "reopened";
+    m_retryMs = 0;
+    return m_fd;
+}
+
+ssize_t SensorHandle::read(void *buf, size_t len)
+{
+    if (fd() < 0) return -1;
+    ssize_t n = ::read(m_fd, buf, len);
+    if (n < 0) checkError();
+    return n;
+}
+
+ssize_t SensorHandle::write(const void *buf, size_t len)
+{
+    if (fd() < 0) return -1;
+    ssize_t n = ::write(m_fd, buf, len);
+    if (n < 0) checkError();
+    return n;
+}
+
+int SensorHandle::ioctl(unsigned long request, unsigned long arg)
+{
+    if (fd() < 0) return -1;
+    int ret = ::ioctl(m_fd, request, arg);
+    if (ret < 0) checkError();
+    return ret;
+}
+
+void SensorHandle::reset()
+{
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+}
+
+void SensorHandle::checkError()
+{
+    // 设备已消失（驱动卸载、热拔出）时关闭，交给退避重开；其它错误保留 fd
+    int err = errno;
+    if (err != ENODEV && err != ENXIO && err != EIO && err != EBADF && err != ESHUTDOWN) return;
+    qWarning() << m_path << "lost:" << strerror(err);
+    reset();
+    m_retryMs = SENSOR_RETRY_MIN_MS;
+    m_sinceFail.start();
+    errno = err;
+}
@@ -0,0 +1,55 @@
+// sensorhandle.h
+#ifndef SENSORHANDLE_H
+#define SENSORHANDLE_H
+
+#include <QElapsedTimer>
+#include <fcntl.h>
+#include <sys/types.h>
+
+// 设备打不开或被移除后的重试间隔：从 100ms 起每次加倍，最长 5s
+#define SENSOR_RETRY_MIN_MS 100
+#define SENSOR_RETRY_MAX_MS 5000
+
+/**
+ * @brief SensorHandle
+ * 传感器字符设备的常驻句柄：第一次使用时打开并配置（如 I2C_SLAVE），
+ * 之后每次采样都复用同一个 fd，省去每次 open/release 和重复配置。
+ *
+ * 读写遇到 ENODEV/ENXIO/EIO 等设备失效错误时关闭 fd，随后按指数退避
+ * 重新打开，驱动重新加载或设备重新插上后自动恢复。
+ * 不加锁，每个句柄只应在一个线程里使用。
+ */
+class SensorHandle
+{
+public:
+    // 打开成功后调用一次，返回 < 0 视为打开失败
+    typedef int (*Setup)(int fd);
+
+    explicit SensorHandle(const char *path, int flags = O_RDWR, Setup setup = nullptr);
+    ~SensorHandle();
+
+    // 可用的 fd；未打开且退避时间已到时尝试重新打开，失败返回 -1
+    int     fd();
+    ssize_t read(void *buf, size_t len);
+    ssize_t write(const void *buf, size_t len);
+    int     ioctl(unsigned long request, unsigned long arg = 0);
+    // 放弃当前 fd，下次使用时立即重新打开
+    void    reset();
+
+    const char *path() const { return m_path; }
+
+private:
+    SensorHandle(const SensorHandle &) = delete;
+    SensorHandle &operator=(const SensorHandle &) = delete;
+
+    void checkError();
+
+    const char    *m_path;
+    int            m_flags;
+    Setup          m_setup;
+    int            m_fd = -1;
+    int            m_retryMs = 0;       // 0 表示可以立即尝试
+    QElapsedTimer  m_sinceFail;
+};
+
+#endif // SENSORHANDLE_H
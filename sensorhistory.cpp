@@ -0,0 +1,87 @@
+// sensorhistory.cpp
+#include "sensorhistory.h"
+#include <string.h>
+
+SensorHistory &SensorHistory::channel(Channel ch)
+{
+    static SensorHistory histories[Channels];
+    return histories[ch];
+}
+
+SensorHistory::SensorHistory(int capacityLog2)
+    : m_mask(((quint64)1 << capacityLog2) - 1),
+      m_timestamps(new std::atomic<qint64>[m_mask + 1]()),
+      m_values(new std::atomic<float>[m_mask + 1]()),
+      m_head(0)
+{
+}
+
+void SensorHistory::append(qint64 timestampUs, float value)
+{
+    quint64 head = m_head.load(std::memory_order_relaxed);
+    quint64 slot = head & m_mask;
+
+    // 先让读线程能看到 m_head == head，再覆盖这一格：
+    // 读到新数据的读线程随后一定能发现这一格已不可信
+    std::atomic_thread_fence(std::memory_order_release);
+    m_timestamps[slot].store(timestampUs, std::memory_order_relaxed);
+    m_values[slot].store(value, std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+int SensorHistory::window(qint64 sinceUs, qint64 *timestamps, float *values, int maxCount) const
+{
+    if (maxCount <= 0) return 0;
+
+    quint64 head = m_head.load(std::memory_order_acquire);
+    quint64 lo = firstValid(head);
+    quint64 hi = head;
+
+    // 时间戳单调，二分查找第一个 >= sinceUs 的序号
+    while (lo < hi) {
+        quint64 mid = lo + (hi - lo) / 2;
+        if (m_timestamps[mid & m_mask].load(std::memory_order_relaxed) < sinceUs) lo = mid + 1;
+        else hi = mid;
+    }
+
+    quint64 first = lo;
+    if (head - first > (quint64)maxCount) first = head - maxCount;
+
+    int n = 0;
+    for (quint64 i = first; i < head; ++i, ++n) {
+        timestamps[n] = m_timestamps[i & m_mask].load(std::memory_order_relaxed);
+        values[n]     = m_values[i & m_mask].load(std::memory_order_relaxed);
+    }
+
+    // 拷贝期间写线程可能已追上来覆盖了最旧的几格，丢掉这部分
+    std::atomic_thread_fence(std::memory_order_acquire);
+    quint64 valid = firstValid(m_head.load(std::memory_order_relaxed));
+    int stale = valid > first ? (int)qMin<quint64>(valid - first, n) : 0;
+    // 二分查找时读到的可能是正被覆盖的格子，起点会偏早；按拷出的时间戳再截一次
+    while (stale < n && timestamps[stale] < sinceUs) ++stale;
+    if (stale > 0) {
+        n -= stale;
+        memmove(timestamps, timestamps + stale, n * sizeof(*timestamps));
+        memmove(values, values + stale, n * sizeof(*values));
+    }
+    return n;
+}
+
+bool SensorHistory::latest(qint64 *timestampUs, float *value) const
+{
+    quint64 head = m_head.load(std::memory_order_acquire);
+    if (head == 0) return false;
+
+    quint64 slot = (head - 1) & m_mask;
+    qint64 ts = m_timestamps[slot].load(std::memory_order_relaxed);
+    float  v  = m_values[slot].load(std::memory_order_relaxed);
+
+    // 最新一格只有在写线程绕满一圈后才会被覆盖，此时改取新的最新样本
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (firstValid(m_head.load(std::memory_order_relaxed)) > head - 1) {
+        return latest(timestampUs, value);
+    }
+    if (timestampUs) *timestampUs = ts;
+    if (value) *value = v;
+    return true;
+}
@@ -0,0 +1,69 @@
+// sensorhistory.h
+#ifndef SENSORHISTORY_H
+#define SENSORHISTORY_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// 每个通道保留的样本数（2 的幂）：16384 个，1Hz 约 4.5 小时，16Hz 测距约 17 分钟
+#define SENSOR_HISTORY_CAPACITY_LOG2 14
+
+/**
+ * @brief SensorHistory
+ * 单通道传感器历史：固定容量的环，时间戳与数值分两列存放，满后覆盖最旧样本，
+ * 长时间运行内存也不增长。
+ *
+ * 只允许一个线程（传感器调度线程）append，任意多个线程同时读取，双方都不加锁；
+ * 读取时把样本拷到调用方提供的数组，读取期间被覆盖的样本会被丢弃，
+ * 返回的一定是一致的 (时间戳, 数值) 对，按时间从旧到新排列。
+ * 目前由 SensorScheduler 写入，MainWindow 读取最近一段时间生成读数标签的趋势提示。
+ */
+class SensorHistory
+{
+public:
+    enum Channel {
+        Gas,            // 可燃气体原始值
+        Distance,       // 滤波后的距离（cm）
+        Light,          // 照度（lx）
+        Temperature,    // 温度（℃）
+        Humidity,       // 湿度（%）
+        Channels
+    };
+
+    // 全局各通道的历史
+    static SensorHistory &channel(Channel ch);
+
+    explicit SensorHistory(int capacityLog2 = SENSOR_HISTORY_CAPACITY_LOG2);
+
+    // 写入一个样本，时间戳（monotonicUs）须单调不减；仅限单个写线程
+    void append(qint64 timestampUs, float value);
+
+    /**
+     * 取 timestampUs >= sinceUs 的样本，超过 maxCount 时只保留最新的 maxCount 个。
+     * 返回拷出的样本数；不分配内存。
+     */
+    int  window(qint64 sinceUs, qint64 *timestamps, float *values, int maxCount) const;
+    // 最新一个样本；没有样本时返回 false
+    bool latest(qint64 *timestampUs, float *value) const;
+
+    int     capacity() const { return (int)(m_mask + 1); }
+    // 累计写入的样本数（含已被覆盖的）
+    quint64 total() const    { return m_head.load(std::memory_order_acquire); }
+
+private:
+    Q_DISABLE_COPY(SensorHistory)
+
+    // 读取期间可能已被写线程覆盖的最早序号之前都不可信
+    quint64 firstValid(quint64 head) const
+    {
+        return head > m_mask ? head - m_mask : 0;
+    }
+
+    const quint64                           m_mask;
+    std::unique_ptr<std::atomic<qint64>[]>  m_timestamps;
+    std::unique_ptr<std::atomic<float>[]>   m_values;
+    std::atomic<quint64>                    m_head;     // 下一个写入的序号
+};
+
+#endif // SENSORHISTORY_H
@@ -0,0 +1,384 @@
+// sensorscheduler.cpp
+#include "sensorscheduler.h"
+#include "dht11reader.h"
+#include "drivermanager.h"
+#include "sensorhistory.h"
+#include "monotonic.h"
+#include <QDebug>
+#include <QWaitCondition>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+// 直接对应驱动中的 IOCTL_LED_OFF = 1, IOCTL_LED_ON = 2, IOCTL_BUZZER_OFF = 3, IOCTL_BUZZER_ON = 4
+#define LED_OFF     1
+#define LED_ON      2
+#define BUZZER_OFF  3
+#define BUZZER_ON   4
+
+static const char *const kTaskNames[SENSOR_TASKS] = {
+    "gas", "ultrasonic", "light", "temphum", "buzzer"
+};
+
+// 做 DHT11 测量的工作线程，由 SensorScheduler::run() 启停；只等请求，不自己计时
+class SensorScheduler::TempHumWorker : public QThread
+{
+public:
+    explicit TempHumWorker(SensorScheduler *scheduler) : m_scheduler(scheduler) {}
+
+    // 请求一次测量；正在测量时只留一个待办，不排队
+    void request()
+    {
+        QMutexLocker locker(&m_lock);
+        m_pending = true;
+        m_wake.wakeOne();
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&m_lock);
+        requestInterruption();
+        m_wake.wakeOne();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_lock);
+        for (;;) {
+            while (!m_pending && !isInterruptionRequested()) m_wake.wait(&m_lock);
+            if (isInterruptionRequested()) return;
+            m_pending = false;
+            locker.unlock();
+            m_scheduler->sampleTempHumidity();
+            locker.relock();
+        }
+    }
+
+private:
+    SensorScheduler *m_scheduler;
+    QMutex           m_lock;
+    QWaitCondition   m_wake;
+    bool             m_pending = false;     // 受 m_lock 保护
+};
+
+SensorScheduler::SensorScheduler(QObject *parent)
+    : QThread(parent)
+    , m_buzzer("/dev/LEDBuzzer")
+{
+    m_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_timerfd < 0) qCritical() << "timerfd_create failed:" << strerror(errno);
+    m_wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakefd < 0) qCritical() << "eventfd failed:" << strerror(errno);
+
+    for (int i = 0; i < SENSOR_TASKS; ++i) {
+        m_periods[i] = (i == LEDBuzzer) ? 0 : SENSOR_DEFAULT_PERIOD_MS;
+        if (i == TempHumidity) m_periods[i] = DHT11_MIN_INTERVAL_MS;
+        if (i == Ultrasonic)   m_periods[i] = RANGING_PERIOD_MS;
+        m_lateSumUs[i] = 0;
+    }
+}
+
+SensorScheduler::~SensorScheduler()
+{
+    stop();
+    wait();
+    if (m_timerfd >= 0) ::close(m_timerfd);
+    if (m_wakefd >= 0)  ::close(m_wakefd);
+}
+
+void SensorScheduler::setPeriod(ProcessMode mode, int periodMs)
+{
+    if (mode < 0 || mode >= SENSOR_TASKS) return;
+    if (m_periods[mode].exchange(qMax(periodMs, 0)) == qMax(periodMs, 0)) return;
+    m_periodsDirty = true;
+    wakeup();
+}
+
+SensorJitter SensorScheduler::jitter(ProcessMode mode)
+{
+    QMutexLocker locker(&m_statsLock);
+    return m_jitter[mode];
+}
+
+void SensorScheduler::startSampling()
+{
+    if (isRunning()) return;
+    start();
+}
+
+void SensorScheduler::stop()
+{
+    // 温湿度工作线程由 run() 在调度循环退出后停掉
+    requestInterruption();
+    wakeup();
+}
+
+void SensorScheduler::wakeup()
+{
+    uint64_t one = 1;
+    if (m_wakefd >= 0 && ::write(m_wakefd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+void SensorScheduler::preloadDrivers()
+{
+    DriverManager::instance().loadAsync(QStringList{
+        "/home/root/vendor/BH1750_driver.ko",
+        "/home/root/vendor/HCSR04_driver.ko",
+        "/home/root/vendor/MQ2_driver.ko",
+        "/home/root/vendor/LEDBuzzer_driver.ko",
+        "/home/root/vendor/DHT11_driver.ko",
+    });
+}
+
+void SensorScheduler::run()
+{
+    // 驱动一般在启动时已开始后台加载，这里只等它完成；缺失的设备由 SensorHandle 退避重试
+    preloadDrivers();
+    if (!DriverManager::instance().waitLoaded()) qWarning() << "[Sensor] some drivers failed to load";
+
+    TempHumWorker tempHum(this);
+    tempHum.start();
+    m_tempHum = &tempHum;
+
+    struct pollfd fds[2];
+    while (!isInterruptionRequested()) {
+        qint64 now = monotonicUs();
+        if (m_periodsDirty.exchange(false)) applyPeriods(now);
+        qint64 next = runDueTasks(now);
+
+        // 定时器按绝对时间设定到最早的截止时刻，没有任务时停掉
+        struct itimerspec its;
+        memset(&its, 0, sizeof(its));
+        if (next >= 0) {
+            its.it_value.tv_sec  = next / 1000000;
+            its.it_value.tv_nsec = (next % 1000000) * 1000;
+            if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) its.it_value.tv_nsec = 1;
+        }
+        int timeout = -1;
+        if (m_timerfd < 0 ||
+            timerfd_settime(m_timerfd, TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
+            // 没有 timerfd 时退回 poll 超时，精度只到毫秒
+            if (next >= 0) timeout = (int)qMax<qint64>(0, (next - monotonicUs() + 999) / 1000);
+        }
+
+        fds[0].fd      = m_wakefd;
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd      = m_timerfd;
+        fds[1].events  = POLLIN;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, timeout) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        uint64_t cnt;
+        if ((fds[0].revents & POLLIN) && ::read(m_wakefd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) {
+            perror("eventfd read");
+        }
+        if ((fds[1].revents & POLLIN) && ::read(m_timerfd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) {
+            perror("timerfd read");
+        }
+    }
+
+    m_tempHum = nullptr;
+    tempHum.stop();
+    tempHum.wait();
+    // 退出时不留一个响着的脉冲
+    if (m_buzzerOffUs) m_buzzer.ioctl(BUZZER_OFF);
+}
+
+void SensorScheduler::applyPeriods(qint64 now)
+{
+    for (int i = 0; i < SENSOR_TASKS; ++i) {
+        Task &task = m_tasks[i];
+        int period = m_periods[i];
+        if (period == task.periodMs) continue;
+        // 新启用的立即采样；改短周期时不必等完旧周期
+        if (task.periodMs == 0) task.deadlineUs = now;
+        else task.deadlineUs = qMin<qint64>(task.deadlineUs, now + period * 1000LL);
+        task.periodMs = period;
+    }
+}
+
+qint64 SensorScheduler::runDueTasks(qint64 now)
+{
+    for (;;) {
+        // 蜂鸣器脉冲到点关断
+        if (m_buzzerOffUs && m_buzzerOffUs <= now) {
+            m_buzzer.ioctl(BUZZER_OFF);
+            m_buzzerOffUs = 0;
+        }
+
+        // 截止时间最早的任务先做
+        int due = -1;
+        qint64 next = -1;
+        for (int i = 0; i < SENSOR_TASKS; ++i) {
+            const Task &task = m_tasks[i];
+            if (task.periodMs <= 0) continue;
+            if (next < 0 || task.deadlineUs < next) {
+                next = task.deadlineUs;
+                due  = i;
+            }
+        }
+        if (due < 0 || next > now) {
+            if (m_buzzerOffUs && (next < 0 || m_buzzerOffUs < next)) {
+                next = m_buzzerOffUs;
+            }
+            return next;
+        }
+
+        Task &task = m_tasks[due];
+        qint64 late = now - task.deadlineUs;
+        sample((ProcessMode)due);
+        now = monotonicUs();
+
+        // 下一次按计划时刻累加；采样太慢错过的整周期直接跳过
+        qint64 period = task.periodMs * 1000LL;
+        task.deadlineUs += period;
+        int missed = 0;
+        if (task.deadlineUs <= now) {
+            missed = (int)((now - task.deadlineUs) / period) + 1;
+            task.deadlineUs += missed * period;
+        }
+        recordLateness((ProcessMode)due, late, missed);
+
+        // 采样里可能改了周期（超声波调整蜂鸣器）
+        if (m_periodsDirty.exchange(false)) applyPeriods(now);
+    }
+}
+
+void SensorScheduler::recordLateness(ProcessMode mode, qint64 lateUs, int missed)
+{
+    QMutexLocker locker(&m_statsLock);
+    SensorJitter &j = m_jitter[mode];
+    j.samples++;
+    j.overruns  += missed;
+    j.maxLateUs  = qMax(j.maxLateUs, lateUs);
+    m_lateSumUs[mode] += lateUs;
+    j.meanLateUs = m_lateSumUs[mode] / j.samples;
+    if (j.samples % JITTER_REPORT_SAMPLES == 0) {
+        qDebug() << "[Sensor]" << kTaskNames[mode] << "jitter mean" << j.meanLateUs
+                 << "us max" << j.maxLateUs << "us overruns" << j.overruns;
+    }
+}
+
+void SensorScheduler::sample(ProcessMode mode)
+{
+    switch (mode) {
+    case BroadGas: {
+        int gas = DataProcess(BroadGas);
+        SensorHistory::channel(SensorHistory::Gas).append(monotonicUs(), gas);
+        setGasAlarm(gas > GAS_ALARM_THRESHOLD);
+        emit gasWarning(gas);
+        break;
+    }
+    case Ultrasonic:
+        sampleRange();
+        break;
+    case LightLevel: {
+        int light = DataProcess(LightLevel);
+        if (light < 0) break;
+        SensorHistory::channel(SensorHistory::Light).append(monotonicUs(), light);
+        emit lightDetected(QString::number(light));
+        break;
+    }
+    case TempHumidity:
+        // 测量在工作线程上做，这里只提交请求
+        if (m_tempHum) m_tempHum->request();
+        break;
+    case LEDBuzzer:
+        pulseBuzzer();
+        break;
+    default:
+        break;
+    }
+}
+
+void SensorScheduler::sampleRange()
+{
+    // 驱动的 read 在回波结束后返回，此刻即为回波时刻
+    long long echo = UltrasonicEcho();
+    qint64 now = monotonicUs();
+    double dist = m_range.push(echo, now);
+    if (dist < 0) return;
+    // 无回波时滤波器保持上一次估计，不当作新的测距记入历史
+    bool fresh = m_range.lastValidUs() == now;
+    if (fresh) SensorHistory::channel(SensorHistory::Distance).append(now, (float)dist);
+
+    if (now - m_rangeUiUs >= RANGE_UI_PERIOD_MS * 1000LL) {
+        m_rangeUiUs = now;
+        emit distanceWarning((float)dist);
+    }
+
+    // 蜂鸣节奏跟随滤波后的距离，距离越近越密，0 表示超出范围不响
+    int interval = calculateBuzzerInterval((float)dist);
+    if (interval != m_buzzerInterval) {
+        m_buzzerInterval = interval;
+        m_cadenceEchoUs  = (fresh && interval > 0) ? now : 0;
+        setPeriod(LEDBuzzer, interval);
+    }
+}
+
+void SensorScheduler::sampleTempHumidity()
+{
+    // 读取器自己限制测量间隔，周期比它短时直接拿到缓存值
+    Dht11Reading reading;
+    if (Dht11Reader::instance().update(&reading)) {
+        // 周期短于测量间隔时拿到的是缓存值，只记录新的测量
+        if (reading.timestampUs > m_lastTempHumUs) {
+            m_lastTempHumUs = reading.timestampUs;
+            SensorHistory::channel(SensorHistory::Temperature).append(reading.timestampUs, reading.temperature);
+            SensorHistory::channel(SensorHistory::Humidity).append(reading.timestampUs, reading.humidity);
+        }
+        emit tempHumDetected(reading.temperature, reading.humidity);
+    }
+}
+
+void SensorScheduler::setGasAlarm(bool on)
+{
+    if (on == m_gasAlarm || m_buzzer.fd() < 0) return;
+    m_gasAlarm = on;
+    // 报警期间蜂鸣器常响，距离节拍暂停；解除后节拍按当前距离继续
+    m_buzzerOffUs = 0;
+    m_buzzer.ioctl(on ? LED_ON : BUZZER_OFF);
+    m_buzzer.ioctl(on ? BUZZER_ON : LED_OFF);
+}
+
+void SensorScheduler::pulseBuzzer()
+{
+    if (m_gasAlarm || m_buzzer.fd() < 0) return;
+    if (m_buzzer.ioctl(BUZZER_ON) < 0) {
+        qWarning() << "ioctl BUZZER_ON failed:" << strerror(errno);
+        return;
+    }
+    qint64 now = monotonicUs();
+    // 关断交给调度循环按截止时刻做，测距节拍不被脉冲占住
+    m_buzzerOffUs = now + BUZZER_PULSE_MS * 1000LL;
+    // 只记录节拍改变后的第一次鸣响：从改变节拍的那次回波到按新节拍响起
+    if (m_cadenceEchoUs) {
+        m_buzzerLatency.add(now - m_cadenceEchoUs);
+        m_cadenceEchoUs = 0;
+        if (m_buzzerLatency.count() % BUZZER_LATENCY_REPORT == 0) {
+            qDebug() << "[Sensor] echo-to-buzzer latency" << m_buzzerLatency.summary();
+        }
+    }
+}
+
+int SensorScheduler::calculateBuzzerInterval(float dist)
+{
+    if (dist <= 50 && dist > 40) return 1000;
+    if (dist <= 40 && dist > 30) return 600;
+    if (dist <= 30 && dist > 20) return 400;
+    if (dist <= 20 && dist > 10) return 200;
+    if (dist <= 10 && dist > 5)  return 100;
+    if (dist <= 5 && dist > 0)   return 50;
+    return 0;
+}
@@ -0,0 +1,119 @@
+// sensorscheduler.h
+#ifndef SENSORSCHEDULER_H
+#define SENSORSCHEDULER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include "dataprocess.h"
+#include "sensorhandle.h"
+#include "rangefilter.h"
+#include "framestats.h"
+
+// 各传感器默认采样周期
+#define SENSOR_DEFAULT_PERIOD_MS 1000
+// 超声波测距周期：约 16Hz，HC-SR04 两次触发至少间隔 60ms 以免收到上一次的余波
+#define RANGING_PERIOD_MS        60
+// 距离送给界面的最短间隔，测距本身不受影响
+#define RANGE_UI_PERIOD_MS       200
+// 气体读数超过此值时 LED 常亮、蜂鸣器长鸣
+#define GAS_ALARM_THRESHOLD      0
+// 距离节拍每次鸣响的时长，到点由定时器关掉
+#define BUZZER_PULSE_MS          10
+// 每记录这么多次节拍改变（回波到按新节拍鸣响）的延迟输出一次统计
+#define BUZZER_LATENCY_REPORT    20
+// 每个传感器每采样这么多次输出一次调度抖动统计
+#define JITTER_REPORT_SAMPLES    60
+// 调度任务数：ProcessMode 的每个值一个，LEDBuzzer 为蜂鸣器脉冲
+#define SENSOR_TASKS             (LEDBuzzer + 1)
+
+// 某个传感器的调度统计：实际开始采样时刻相对计划时刻的延迟
+struct SensorJitter {
+    int     samples   = 0;
+    int     overruns  = 0;      // 上一次采样太慢而整周期跳过的次数
+    qint64  meanLateUs = 0;
+    qint64  maxLateUs  = 0;
+};
+
+/**
+ * @brief SensorScheduler
+ * 单线程传感器采集调度器，代替每种传感器一个 QThread + QTimer。
+ *
+ * 传感器按各自周期排在截止时间队列里，线程只阻塞在一个 timerfd（绝对时间，
+ * CLOCK_MONOTONIC）和一个唤醒 eventfd 上；到期的传感器依次采样，下一次截止
+ * 时间按计划时刻累加，不随采样耗时漂移。
+ * DHT11 一次测量要阻塞约 25ms，会拖累 60ms 的测距节拍，只有它交给一个工作线程：
+ * 调度线程到期时提交请求，工作线程测完直接写历史、发信号；上一次没测完时请求合并。
+ * 超声波距离决定蜂鸣器脉冲周期，脉冲的关断也是一个截止时刻，不在线程里睡眠。
+ */
+class SensorScheduler : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SensorScheduler(QObject *parent = nullptr);
+    ~SensorScheduler() override;
+
+    // 设置某个传感器的采样周期，0 停止采样；任意线程可调用
+    void setPeriod(ProcessMode mode, int periodMs);
+    // 调度统计快照，任意线程可调用
+    SensorJitter jitter(ProcessMode mode);
+    // 开始采样；已在运行时什么也不做，可重复调用
+    void startSampling();
+    // 请求线程退出
+    void stop();
+    // 在后台并行加载传感器驱动，进程内只生效一次；启动时调用，不必等调度线程
+    static void preloadDrivers();
+
+signals:
+    void gasWarning(int);
+    void distanceWarning(float);
+    void lightDetected(const QString &);
+    void tempHumDetected(float temperature, float humidity);
+
+protected:
+    void run() override;
+
+private:
+    class TempHumWorker;
+
+    struct Task {
+        int     periodMs   = 0;
+        qint64  deadlineUs = 0;
+    };
+
+    void applyPeriods(qint64 now);
+    qint64 runDueTasks(qint64 now);
+    void sample(ProcessMode mode);
+    void sampleTempHumidity();
+    void sampleRange();
+    void recordLateness(ProcessMode mode, qint64 lateUs, int missed);
+    void pulseBuzzer();
+    void setGasAlarm(bool on);
+    int  calculateBuzzerInterval(float dist);
+    void wakeup();
+
+    int               m_timerfd = -1;
+    int               m_wakefd  = -1;
+    Task              m_tasks[SENSOR_TASKS];            // 仅调度线程访问
+    std::atomic<int>  m_periods[SENSOR_TASKS];          // 请求的周期，由调度线程同步到 m_tasks
+    std::atomic<bool> m_periodsDirty{true};
+    QMutex            m_statsLock;
+    SensorJitter      m_jitter[SENSOR_TASKS];           // 受 m_statsLock 保护
+    qint64            m_lateSumUs[SENSOR_TASKS];
+    // 以下仅调度线程访问
+    TempHumWorker    *m_tempHum = nullptr;      // run() 期间有效
+    SensorHandle      m_buzzer;
+    bool              m_gasAlarm = false;       // 气体报警中，蜂鸣器常响，不再打距离节拍
+    qint64            m_buzzerOffUs = 0;        // 当前脉冲的关断时刻，0 表示没有在响
+    RangeFilter       m_range;
+    qint64            m_rangeUiUs = 0;          // 上次把距离送给界面的时刻
+    int               m_buzzerInterval = 0;
+    qint64            m_cadenceEchoUs = 0;      // 改变蜂鸣节拍的回波时刻，新节拍第一次鸣响后清零
+    LatencyHistogram  m_buzzerLatency;
+    // 仅温湿度工作线程访问
+    qint64            m_lastTempHumUs = 0;      // 已写入历史的最近一次温湿度测量时刻
+};
+
+#endif // SENSORSCHEDULER_H
@@ -0,0 +1,49 @@
+#-------------------------------------------------
+#
+# 纯逻辑部分的单元测试，不访问摄像头与传感器设备
+#
+# 运行：qmake tests.pro && make check
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+QT       -= widgets
+
+TARGET = tst_geoprospector
+TEMPLATE = app
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        tst_geoprospector.cpp \
+    ../yuvconvert.cpp \
+    ../framemailbox.cpp \
+    ../framepairer.cpp \
+    ../framering.cpp \
+    ../jpegcrop.cpp \
+    ../rangefilter.cpp \
+    ../sensorhistory.cpp \
+    ../camerathread.cpp \
+    ../framepool.cpp \
+    ../framestats.cpp \
+    ../motiondetector.cpp \
+    ../monotonic.cpp
+
+HEADERS += \
+    ../yuvconvert.h \
+    ../framemailbox.h \
+    ../framepairer.h \
+    ../framering.h \
+    ../jpegcrop.h \
+    ../rangefilter.h \
+    ../sensorhistory.h \
+    ../camerathread.h \
+    ../framepool.h \
+    ../framestats.h \
+    ../motiondetector.h \
+    ../monotonic.h
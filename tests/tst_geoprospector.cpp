@@ -0,0 +1,484 @@
+// tst_geoprospector.cpp
+
+#include <QtTest>
+#include <QBuffer>
+#include <QImage>
+#include <vector>
+#include "yuvconvert.h"
+#include "framemailbox.h"
+#include "framepairer.h"
+#include "framering.h"
+#include "jpegcrop.h"
+#include "camerathread.h"
+#include "rangefilter.h"
+#include "sensorhistory.h"
+
+// 固定种子的伪随机数，保证每次运行数据一致
+static quint32 nextRandom(quint32 *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void fillRandom(unsigned char *data, int size, quint32 seed)
+{
+    for (int i = 0; i < size; ++i) data[i] = (unsigned char)nextRandom(&seed);
+}
+
+// BT.601 有限范围，与 yuvconvert.cpp 的标量参考实现同一公式
+static void referenceYuyv(const unsigned char *yuyv, unsigned char *rgb, int pixels)
+{
+    for (int j = 0; j < pixels; j += 2, yuyv += 4) {
+        int u  = yuyv[1] - 128;
+        int v  = yuyv[3] - 128;
+        int rv = (409 * v) >> 8;
+        int gv = (100 * u + 208 * v) >> 8;
+        int bu = (516 * u) >> 8;
+        for (int k = 0; k < 2; ++k) {
+            int c = (298 * (yuyv[k * 2] - 16) + 128) >> 8;
+            *rgb++ = qBound(0, c + rv, 255);
+            *rgb++ = qBound(0, c - gv, 255);
+            *rgb++ = qBound(0, c + bu, 255);
+        }
+    }
+}
+
+class TestGeoProspector : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void yuyvMatchesReference_data();
+    void yuyvMatchesReference();
+    void frameMailboxKeepsLatest();
+    void framePairerMatchesClosest();
+    void framePairerSendsAloneWhenStale();
+    void frameRingKeepsSharpestPerBucket();
+    void frameRingExpiresOldFrames();
+    void frameRingBucketEmpty();
+    void imageFocusPrefersSharp();
+    void lumaSadMatchesReference();
+    void jpegCropKeepsPixels();
+    void snapshotIsFullResolution();
+    void rangeFilterConverges();
+    void rangeFilterRejectsSpike();
+    void rangeFilterHoldsDuringDropout();
+    void sensorHistoryWindow();
+    void sensorHistoryWraparound();
+};
+
+void TestGeoProspector::yuyvMatchesReference_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    // 覆盖各向量内核的整块、尾部与纯标量宽度
+    QTest::newRow("2x1")     << 2   << 1;
+    QTest::newRow("14x3")    << 14  << 3;
+    QTest::newRow("16x2")    << 16  << 2;
+    QTest::newRow("34x5")    << 34  << 5;
+    QTest::newRow("66x4")    << 66  << 4;
+    QTest::newRow("640x8")   << 640 << 8;
+}
+
+void TestGeoProspector::yuyvMatchesReference()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    // 行尾留出填充，检查按 stride 取行且不越界写
+    int srcStride = width * 2 + 6;
+    int dstStride = width * 3 + 5;
+    std::vector<unsigned char> src(srcStride * height);
+    fillRandom(src.data(), (int)src.size(), width * 131 + height);
+    // 第一行放极值，检查饱和
+    for (int i = 0; i < width * 2 && i < 8; ++i) src[i] = (i & 1) ? 0 : 255;
+
+    std::vector<unsigned char> dst(dstStride * height, 0xa5);
+    yuyv_to_rgb888(src.data(), srcStride, dst.data(), dstStride, width, height);
+
+    std::vector<unsigned char> expect(width * 3);
+    for (int row = 0; row < height; ++row) {
+        referenceYuyv(&src[row * srcStride], expect.data(), width);
+        QVERIFY2(memcmp(&dst[row * dstStride], expect.data(), width * 3) == 0,
+                 qPrintable(QString("row %1 differs, kernel %2").arg(row).arg(yuyvKernelName())));
+        for (int i = width * 3; i < dstStride; ++i) QCOMPARE(dst[row * dstStride + i], (unsigned char)0xa5);
+    }
+}
+
+void TestGeoProspector::frameMailboxKeepsLatest()
+{
+    FrameMailbox box;
+    QSignalSpy spy(&box, SIGNAL(frameAvailable()));
+    QImage image(4, 4, QImage::Format_RGB32);
+    for (int i = 1; i <= 3; ++i) {
+        FrameInfo info;
+        info.sequence = i;
+        box.post(image, info);
+    }
+    // 空->满只通知一次，之后的帧覆盖
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(box.posted(), (quint64)3);
+    QCOMPARE(box.dropped(), (quint64)2);
+
+    QImage frame;
+    FrameInfo info;
+    QVERIFY(box.take(&frame, &info));
+    QCOMPARE(info.sequence, (quint32)3);
+    QVERIFY(!box.take(&frame, &info));
+
+    box.post(image, info);
+    QCOMPARE(spy.count(), 2);
+}
+
+void TestGeoProspector::framePairerMatchesClosest()
+{
+    FramePairer pairer(5000);
+    QSignalSpy spy(&pairer, SIGNAL(pairAvailable()));
+    QImage a(4, 4, QImage::Format_RGB32), b(2, 2, QImage::Format_RGB32);
+    FrameInfo info;
+
+    // 时间戳从开机算起，两路刚启动时都不算停流
+    info.timestampUs = 10000;
+    pairer.postFirst(a, info);
+    info.timestampUs = 13000;
+    pairer.postSecond(b, info);
+    QCOMPARE(spy.count(), 1);
+
+    FramePair pair;
+    QVERIFY(pairer.take(&pair));
+    QVERIFY(pair.complete());
+    QCOMPARE(pair.image[0].size(), a.size());
+    QCOMPARE(pair.image[1].size(), b.size());
+    QCOMPARE(pair.skewUs(), (qint64)-3000);
+    QCOMPARE(pairer.paired(), (quint64)1);
+
+    // 时间差超过上限的不配对
+    info.timestampUs = 20000;
+    pairer.postFirst(a, info);
+    info.timestampUs = 30000;
+    pairer.postSecond(b, info);
+    QVERIFY(!pairer.take(&pair));
+    // 第一路下一帧与第二路等待中的帧配上，第一路较旧的那帧丢弃
+    info.timestampUs = 31000;
+    pairer.postFirst(a, info);
+    QVERIFY(pairer.take(&pair));
+    QCOMPARE(pair.info[0].timestampUs, (qint64)31000);
+    QCOMPARE(pair.info[1].timestampUs, (qint64)30000);
+    QCOMPARE(pairer.dropped(), (quint64)1);
+}
+
+void TestGeoProspector::framePairerSendsAloneWhenStale()
+{
+    FramePairer pairer(5000);
+    QImage a(4, 4, QImage::Format_RGB32), b(2, 2, QImage::Format_RGB32);
+    FrameInfo info;
+    info.timestampUs = 1000;
+    pairer.postSecond(b, info);
+
+    // 第二路超过 10 个配对窗口没有新帧：第一路单独送出
+    FramePair pair;
+    info.timestampUs = 1000 + 5000 * 10 + 1;
+    pairer.postFirst(a, info);
+    QVERIFY(pairer.take(&pair));
+    QVERIFY(!pair.complete());
+    QVERIFY(!pair.image[0].isNull());
+    QVERIFY(pair.image[1].isNull());
+    QCOMPARE(pair.info[0].timestampUs, info.timestampUs);
+}
+
+void TestGeoProspector::frameRingKeepsSharpestPerBucket()
+{
+    // 800ms 分 8 格，每格 100ms
+    FrameRing ring(800, 8);
+    unsigned char data[8] = { 0 };
+    RingFrame frame;
+    QVERIFY(!ring.sharpest(&frame, 1000000));
+
+    FrameInfo info;
+    const double focus[] = { 5, 9, 3, 7 };
+    for (int i = 0; i < 4; ++i) {
+        info.sequence    = i;
+        info.timestampUs = 1000000 + i * 100000;
+        data[0] = (unsigned char)i;
+        ring.addRaw(info, focus[i], data, sizeof(data), V4L2_PIX_FMT_YUYV, 2, 2, 4);
+    }
+    QVERIFY(ring.sharpest(&frame, 1350000));
+    QCOMPARE(frame.info.sequence, (quint32)1);
+    QCOMPARE(frame.focus, 9.0);
+    QCOMPARE((int)(unsigned char)frame.data[0], 1);
+
+    // 同一格里较模糊的帧不替换，更清晰的替换
+    info.sequence    = 10;
+    info.timestampUs = 1150000;
+    ring.addRaw(info, 8, data, sizeof(data), V4L2_PIX_FMT_YUYV, 2, 2, 4);
+    QVERIFY(ring.sharpest(&frame, 1350000));
+    QCOMPARE(frame.info.sequence, (quint32)1);
+    info.sequence = 11;
+    ring.addRaw(info, 12, data, sizeof(data), V4L2_PIX_FMT_YUYV, 2, 2, 4);
+    QVERIFY(ring.sharpest(&frame, 1350000));
+    QCOMPARE(frame.info.sequence, (quint32)11);
+}
+
+void TestGeoProspector::frameRingExpiresOldFrames()
+{
+    FrameRing ring(800, 8);
+    QByteArray jpeg("\xff\xd8 not decoded here");
+    FrameInfo info;
+    info.sequence    = 1;
+    info.timestampUs = 1000000;
+    ring.addJpeg(info, 4, jpeg, 640, 480);
+    info.sequence    = 2;
+    info.timestampUs = 1500000;
+    ring.addJpeg(info, 2, jpeg, 640, 480);
+
+    RingFrame frame;
+    QVERIFY(ring.sharpest(&frame, 1600000));
+    QCOMPARE(frame.info.sequence, (quint32)1);
+    QVERIFY(frame.isJpeg());
+    // 窗口移过第一帧后只剩第二帧，再往后整个环都过期
+    QVERIFY(ring.sharpest(&frame, 1900000));
+    QCOMPARE(frame.info.sequence, (quint32)2);
+    QVERIFY(!ring.sharpest(&frame, 2400000));
+
+    // 一整个窗口之后落到同一格的新帧覆盖旧帧，即使评分更低
+    info.sequence    = 3;
+    info.timestampUs = 1000000 + 800000;
+    ring.addJpeg(info, 1, jpeg, 640, 480);
+    QVERIFY(ring.sharpest(&frame, 2400000));
+    QCOMPARE(frame.info.sequence, (quint32)3);
+}
+
+void TestGeoProspector::lumaSadMatchesReference()
+{
+    std::vector<unsigned char> a(257), b(257);
+    fillRandom(a.data(), (int)a.size(), 1);
+    fillRandom(b.data(), (int)b.size(), 2);
+    for (int ystep = 1; ystep <= 2; ++ystep) {
+        // 从 1 字节开始，覆盖向量块内外的各种尾部长度
+        for (int bytes = 0; bytes <= (int)a.size(); bytes += 7) {
+            for (int offset = 0; offset < 2 && offset + bytes <= (int)a.size(); ++offset) {
+                unsigned long long expect = 0;
+                for (int i = 0; i < bytes; i += ystep) expect += qAbs(a[offset + i] - b[offset + i]);
+                QCOMPARE(luma_sad(a.data() + offset, b.data() + offset, bytes, ystep), expect);
+            }
+        }
+    }
+}
+
+void TestGeoProspector::frameRingBucketEmpty()
+{
+    FrameRing ring(800, 8);
+    unsigned char data[8] = { 0 };
+    FrameInfo info;
+    info.timestampUs = 1000000;
+    QVERIFY(ring.bucketEmpty(info));
+    ring.addRaw(info, 0, data, sizeof(data), V4L2_PIX_FMT_YUYV, 2, 2, 4);
+    QVERIFY(!ring.bucketEmpty(info));
+    // 同一格的另一帧、下一格、一整个窗口之后的同一格
+    info.timestampUs = 1099999;
+    QVERIFY(!ring.bucketEmpty(info));
+    info.timestampUs = 1100000;
+    QVERIFY(ring.bucketEmpty(info));
+    info.timestampUs = 1800000;
+    QVERIFY(ring.bucketEmpty(info));
+}
+
+void TestGeoProspector::imageFocusPrefersSharp()
+{
+    // 同一图案：清晰的棋盘格与缩小再放大后的模糊版本
+    QImage sharp(160, 120, QImage::Format_RGB32);
+    for (int y = 0; y < sharp.height(); ++y) {
+        for (int x = 0; x < sharp.width(); ++x) {
+            sharp.setPixel(x, y, ((x / 2 + y / 2) & 1) ? qRgb(230, 220, 210) : qRgb(20, 30, 40));
+        }
+    }
+    QImage blurred = sharp.scaled(40, 30, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                          .scaled(160, 120, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    QVector<unsigned char> luma;
+    double sharpFocus = imageFocus(sharp, &luma);
+    QVERIFY(sharpFocus > imageFocus(blurred, &luma) * 4);
+    // 非 RGB32 输入先转换，结果一致
+    QCOMPARE(imageFocus(sharp.convertToFormat(QImage::Format_RGB888), &luma), sharpFocus);
+    QCOMPARE(imageFocus(QImage(), &luma), 0.0);
+}
+
+void TestGeoProspector::jpegCropKeepsPixels()
+{
+    // 平滑渐变加一些纹理，Qt 默认按 4:2:0 基线编码（MCU 16x16）
+    QImage source(96, 64, QImage::Format_RGB32);
+    for (int y = 0; y < source.height(); ++y) {
+        for (int x = 0; x < source.width(); ++x) {
+            source.setPixel(x, y, qRgb(x * 2, y * 3, ((x / 4 + y / 4) & 1) ? 200 : 40));
+        }
+    }
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(source.save(&buffer, "JPG", 90));
+    QImage decoded = QImage::fromData(jpeg, "JPG").convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(decoded.size(), source.size());
+
+    std::vector<unsigned char> out;
+    int outX = -1, outY = -1;
+    QVERIFY(jpegCropLossless((const unsigned char*)jpeg.constData(), jpeg.size(),
+                             20, 20, 40, 24, &out, &outX, &outY));
+    // 向外对齐到 MCU：x 16..64，y 16..48
+    QCOMPARE(outX, 16);
+    QCOMPARE(outY, 16);
+    QImage cropped = QImage::fromData(out.data(), (int)out.size(), "JPG")
+                         .convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(cropped.size(), QSize(48, 32));
+
+    // 系数原样保留：除去色度上采样受裁剪边界影响的几个像素，解码结果与原图对应区域一致
+    const int margin = 4;
+    for (int y = margin; y < cropped.height() - margin; ++y) {
+        for (int x = margin; x < cropped.width() - margin; ++x) {
+            QCOMPARE(cropped.pixel(x, y), decoded.pixel(outX + x, outY + y));
+        }
+    }
+
+    // 完全在图外的区域
+    QVERIFY(!jpegCropLossless((const unsigned char*)jpeg.constData(), jpeg.size(),
+                              200, 200, 10, 10, &out));
+    // 不是 JPEG
+    QVERIFY(!jpegCropLossless((const unsigned char*)"abcd", 4, 0, 0, 1, 1, &out));
+}
+
+void TestGeoProspector::rangeFilterConverges()
+{
+    RangeFilter filter;
+    QCOMPARE(filter.push(-1, 0), -1.0);
+    double d = -1;
+    for (int i = 0; i < 50; ++i) d = filter.push(1000, i * 60000LL);
+    QVERIFY(qAbs(d - 1000 * ECHO_US_TO_CM) < 0.1);
+}
+
+void TestGeoProspector::rangeFilterRejectsSpike()
+{
+    RangeFilter filter;
+    qint64 t = 0;
+    for (int i = 0; i < 20; ++i, t += 60000) filter.push(2000, t);
+    // 单次多径尖峰被中值窗口挡住
+    double d = filter.push(20000, t);
+    QVERIFY(qAbs(d - 2000 * ECHO_US_TO_CM) < 0.5);
+}
+
+void TestGeoProspector::rangeFilterHoldsDuringDropout()
+{
+    RangeFilter filter;
+    qint64 t = 0;
+    // 匀速靠近，滤波器带着负速度
+    for (int i = 0; i < 30; ++i, t += 60000) filter.push(3000 - i * 20, t);
+    double last = filter.push(3000 - 30 * 20, t);
+    QCOMPARE(filter.lastValidUs(), t);
+    // 短时丢失：保持上一次估计，不外推，也不算作有效测量
+    for (int i = 1; i <= 5; ++i) QCOMPARE(filter.push(0, t + i * 60000), last);
+    QCOMPARE(filter.lastValidUs(), t);
+    // 超过 RANGE_STALE_US 后重置，没有有效值
+    QCOMPARE(filter.push(0, t + 2000000), -1.0);
+    // 回波恢复后重新给出距离
+    QVERIFY(filter.push(1500, t + 2060000) > 0);
+}
+
+void TestGeoProspector::sensorHistoryWindow()
+{
+    SensorHistory history(4);
+    qint64 ts[16];
+    float  values[16];
+    QCOMPARE(history.window(0, ts, values, 16), 0);
+    QVERIFY(!history.latest(nullptr, nullptr));
+
+    for (int i = 0; i < 10; ++i) history.append(i * 100, i);
+    int n = history.window(450, ts, values, 16);
+    QCOMPARE(n, 5);
+    QCOMPARE(ts[0], (qint64)500);
+    QCOMPARE(values[4], 9.0f);
+    // 超过 maxCount 时只保留最新的
+    n = history.window(0, ts, values, 3);
+    QCOMPARE(n, 3);
+    QCOMPARE(ts[0], (qint64)700);
+    QCOMPARE(ts[2], (qint64)900);
+
+    qint64 lastTs = 0;
+    float  lastValue = 0;
+    QVERIFY(history.latest(&lastTs, &lastValue));
+    QCOMPARE(lastTs, (qint64)900);
+    QCOMPARE(lastValue, 9.0f);
+}
+
+void TestGeoProspector::sensorHistoryWraparound()
+{
+    SensorHistory history(4);
+    QCOMPARE(history.capacity(), 16);
+    for (int i = 0; i < 100; ++i) history.append(i * 10, i);
+    QCOMPARE(history.total(), (quint64)100);
+
+    qint64 ts[32];
+    float  values[32];
+    // 写满多圈后只剩最近的样本，按时间从旧到新且连续
+    int n = history.window(0, ts, values, 32);
+    QVERIFY(n > 0 && n <= 16);
+    QCOMPARE(ts[n - 1], (qint64)990);
+    for (int i = 1; i < n; ++i) {
+        QCOMPARE(ts[i] - ts[i - 1], (qint64)10);
+        QCOMPARE(values[i], (float)(ts[i] / 10));
+    }
+    // 起点落在已覆盖区域之内时按时间截取
+    n = history.window(950, ts, values, 32);
+    QCOMPARE(n, 5);
+    QCOMPARE(ts[0], (qint64)950);
+    QCOMPARE(history.window(2000, ts, values, 32), 0);
+}
+
+void TestGeoProspector::snapshotIsFullResolution()
+{
+    // 设备打不开，采集线程不启动；手工装上协商结果和一块 YUYV 缓冲
+    CaptureConfig config;
+    config.device = "/dev/null-camera";
+    config.ringMs = 0;
+    cameraThread cam(config);
+    const int width = 64, height = 48;
+    std::vector<unsigned char> yuyv(width * 2 * height);
+    fillRandom(yuyv.data(), (int)yuyv.size(), 7);
+    struct buffer buf = { yuyv.data(), yuyv.size(), -1 };
+    cam.width        = width;
+    cam.height       = height;
+    cam.pixfmt       = V4L2_PIX_FMT_YUYV;
+    cam.bytesPerLine = width * 2;
+    cam.imageSize    = (int)yuyv.size();
+    cam.framePool    = FramePool::create(FRAME_POOL_SLOTS, cam.rgbStride() * height);
+    cam.buffers      = &buf;
+    cam.nbuffers     = 1;
+    CLEAR(cam.tV4L2buf);
+    cam.tV4L2buf.bytesused = (__u32)yuyv.size();
+
+    FrameMailbox preview;
+    connect(&cam, SIGNAL(previewReady(QImage,FrameInfo)),
+            &preview, SLOT(post(QImage,FrameInfo)), Qt::DirectConnection);
+    cam.setPreviewSize(QSize(16, 12));
+    cam.setSkipStillPreview(false);     // 每次送的是同一帧，不能被当作静止画面跳过
+
+    // 只出预览帧时 snapshot() 没有可返回的帧
+    QImage image;
+    cam.storeImage();
+    QVERIFY(preview.take(&image));
+    QCOMPARE(image.size(), QSize(16, 12));
+    QVERIFY(!cam.snapshot(&image));
+
+    // 全分辨率帧生成后 snapshot() 返回它，之后的预览帧不覆盖
+    cam.requestFullFrame();
+    cam.storeImage();
+    cam.setPreviewSize(QSize(32, 24));
+    cam.storeImage();
+    QVERIFY(preview.take(&image));
+    QCOMPARE(image.size(), QSize(32, 24));
+    QVERIFY(cam.snapshot(&image));
+    QCOMPARE(image.size(), QSize(width, height));
+
+    // 缓冲区不是 mmap 得来的，析构前摘掉
+    cam.buffers  = nullptr;
+    cam.nbuffers = 0;
+}
+
+QTEST_GUILESS_MAIN(TestGeoProspector)
+
+#include "tst_geoprospector.moc"
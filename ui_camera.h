@@ -17,13 +17,14 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QWidget>
+#include "videoview.h"
 
 QT_BEGIN_NAMESPACE
 
 class Ui_camera
 {
 public:
-    QLabel *cameraLabel;
+    VideoView *cameraLabel;
     QPushButton *startButton;
 
     void setupUi(QWidget *camera)
@@ -31,7 +32,7 @@ public:
         if (camera->objectName().isEmpty())
             camera->setObjectName(QStringLiteral("camera"));
         camera->resize(800, 480);
-        cameraLabel = new QLabel(camera);
+        cameraLabel = new VideoView(camera);
         cameraLabel->setObjectName(QStringLiteral("cameraLabel"));
         cameraLabel->setGeometry(QRect(0, 0, 640, 480));
         QSizePolicy sizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
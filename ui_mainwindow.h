@@ -18,6 +18,7 @@
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QPushButton>
 #include <QtWidgets/QWidget>
+#include "videoview.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -33,7 +34,7 @@ public:
     QPushButton *lightButton;
     QPushButton *temperButton;
     QPushButton *gasButton;
-    QLabel *viewlabel;
+    VideoView *viewlabel;
     QPushButton *startButton;
     QLabel *label_3;
     QLabel *label_4;
@@ -93,13 +94,12 @@ public:
         gasButton->setObjectName(QStringLiteral("gasButton"));
         gasButton->setGeometry(QRect(500, 340, 120, 40));
         gasButton->setFont(font1);
-        viewlabel = new QLabel(centralWidget);
+        viewlabel = new VideoView(centralWidget);
         viewlabel->setObjectName(QStringLiteral("viewlabel"));
         viewlabel->setGeometry(QRect(10, 110, 480, 360));
         QFont font2;
         font2.setPointSize(14);
         viewlabel->setFont(font2);
-        viewlabel->setAlignment(Qt::AlignCenter);
         startButton = new QPushButton(centralWidget);
         startButton->setObjectName(QStringLiteral("startButton"));
         startButton->setGeometry(QRect(20, 70, 120, 40));
@@ -0,0 +1,70 @@
+// videoview.cpp
+
+#include "videoview.h"
+#include <QPainter>
+#include <QPaintEvent>
+
+VideoView::VideoView(QWidget *parent)
+    : QWidget(parent)
+{
+    // 背景由 paintEvent 自己画，省去每帧先擦除整个控件
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void VideoView::setFrame(const QImage &frame, const QImage &inset)
+{
+    m_frame = frame;
+    m_inset = inset;
+    // 隐藏时只保留最新帧，重新显示时 Qt 会自动重绘
+    if (isVisible()) update();
+}
+
+void VideoView::clear()
+{
+    m_frame = QImage();
+    m_inset = QImage();
+    update();
+}
+
+void VideoView::setText(const QString &text)
+{
+    m_text = text;
+    if (m_frame.isNull()) update();
+}
+
+QRect VideoView::frameRect() const
+{
+    // 保持宽高比居中放入控件
+    QSize size = m_frame.size().scaled(this->size(), Qt::KeepAspectRatio);
+    return QRect((width() - size.width()) / 2, (height() - size.height()) / 2,
+                 size.width(), size.height());
+}
+
+void VideoView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    if (m_frame.isNull()) {
+        painter.fillRect(rect(), palette().window());
+        painter.setPen(palette().windowText().color());
+        painter.drawText(rect(), Qt::AlignCenter, m_text);
+        return;
+    }
+
+    QRect target = frameRect();
+    if (target != rect()) {
+        // 只有四周留白的部分才需要填背景
+        QRegion border = QRegion(event->rect()).subtracted(target);
+        for (const QRect &r : border.rects()) painter.fillRect(r, palette().window());
+    }
+    // 预览帧一般已按控件尺寸生成，此时为不缩放的直接拷贝
+    if (target.size() == m_frame.size()) painter.drawImage(target.topLeft(), m_frame);
+    else                                 painter.drawImage(target, m_frame);
+
+    if (!m_inset.isNull()) {
+        QRect rect(target.right() - m_inset.width() - 3, target.bottom() - m_inset.height() - 3,
+                   m_inset.width(), m_inset.height());
+        painter.drawImage(rect.topLeft(), m_inset);
+        painter.setPen(Qt::white);
+        painter.drawRect(rect.adjusted(-1, -1, 0, 0));
+    }
+}
@@ -0,0 +1,44 @@
+// videoview.h
+#ifndef VIDEOVIEW_H
+#define VIDEOVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QString>
+
+/**
+ * @brief VideoView
+ * 预览显示控件，代替 QLabel::setPixmap。
+ *
+ * 直接持有采集线程送来的池化 QImage（不转 QPixmap、不拷贝），在 paintEvent
+ * 里画到窗口上：帧尺寸与控件一致时是一次直接的 RGB32 块拷贝，不一致时用
+ * 最近邻缩放。只有新帧到达且控件可见时才请求重绘，也不触发布局检查。
+ * 没有帧时居中显示 text()。
+ */
+class VideoView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit VideoView(QWidget *parent = nullptr);
+
+    // 显示新的一帧；inset 非空时以小窗叠加在右下角（双摄微距画面）
+    void setFrame(const QImage &frame, const QImage &inset = QImage());
+    // 放下当前帧（归还池槽），改为显示提示文字
+    void clear();
+
+    void setText(const QString &text);
+    QString text() const { return m_text; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QRect frameRect() const;
+
+    QImage  m_frame;
+    QImage  m_inset;
+    QString m_text;
+};
+
+#endif // VIDEOVIEW_H
@@ -0,0 +1,503 @@
+// yuvconvert.cpp
+
+#include "yuvconvert.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtGlobal>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define YUV_HAVE_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// ARM 上 NEON 是编译期选择：目标板工具链（cortexa9hf-vfp-neon）默认带 -mfpu=neon，
+// 编译器只在生成 NEON 代码时定义该宏，此时程序本身就要求 CPU 有 NEON，不再运行时检测
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define YUV_HAVE_NEON 1
+#include <arm_neon.h>
+#elif defined(__arm__) || defined(__aarch64__)
+// ARM 上没带 NEON 编译：CPU 即使有 NEON 也用不上，报告内核时要说明，
+// 免得把标量版本误当成运行时检测的结果
+#define YUV_NEON_NOT_BUILT 1
+#endif
+
+// 一段连续像素的转换函数，pixels 为偶数
+typedef void (*YuyvRowFunc)(const unsigned char *src, unsigned char *dst, int pixels);
+
+// ---------------------------------------------------------------------------
+// 标量参考实现（BT.601，有限范围），其余内核的结果必须与之逐位一致
+// ---------------------------------------------------------------------------
+static void yuyvRowScalar(const unsigned char *yuyv, unsigned char *rgb, int pixels)
+{
+    for (int j = 0; j < pixels; j += 2) {
+        int y0 = *yuyv++ - 16;
+        int u  = *yuyv++ - 128;
+        int y1 = *yuyv++ - 16;
+        int v  = *yuyv++ - 128;
+        int c0 = (298*y0 + 128) >> 8;
+        int c1 = (298*y1 + 128) >> 8;
+        int rv = (409 * v) >> 8;
+        int gv = (100 * u + 208 * v) >> 8;
+        int bu = (516 * u) >> 8;
+        *rgb++ = qBound(0, c0 + rv, 255);
+        *rgb++ = qBound(0, c0 - gv, 255);
+        *rgb++ = qBound(0, c0 + bu, 255);
+        *rgb++ = qBound(0, c1 + rv, 255);
+        *rgb++ = qBound(0, c1 - gv, 255);
+        *rgb++ = qBound(0, c1 + bu, 255);
+    }
+}
+
+#ifdef YUV_HAVE_X86
+// 8 个像素（16 字节 YUYV）-> 每通道 8 个 int16，运算全部在 32 位中完成以保证与标量一致
+static inline void yuyv8Sse2(__m128i in, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    const __m128i k16  = _mm_set1_epi16(16);
+    const __m128i k128 = _mm_set1_epi16(128);
+    const __m128i one  = _mm_set1_epi16(1);
+    const __m128i kY   = _mm_set1_epi32((128 << 16) | 298);   // 298*y + 128*1
+    const __m128i kR   = _mm_set1_epi32(409 << 16);           // 0*u + 409*v
+    const __m128i kG   = _mm_set1_epi32((208 << 16) | 100);   // 100*u + 208*v
+    const __m128i kB   = _mm_set1_epi32(516);                 // 516*u + 0*v
+
+    __m128i y  = _mm_sub_epi16(_mm_and_si128(in, mask), k16);
+    __m128i uv = _mm_sub_epi16(_mm_srli_epi16(in, 8), k128);
+
+    __m128i cLo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, one), kY), 8);
+    __m128i cHi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, one), kY), 8);
+
+    // 每对像素共用一组色度，复制到两个像素
+    __m128i rv = _mm_srai_epi32(_mm_madd_epi16(uv, kR), 8);
+    __m128i gv = _mm_srai_epi32(_mm_madd_epi16(uv, kG), 8);
+    __m128i bu = _mm_srai_epi32(_mm_madd_epi16(uv, kB), 8);
+
+    r = _mm_packs_epi32(_mm_add_epi32(cLo, _mm_unpacklo_epi32(rv, rv)),
+                        _mm_add_epi32(cHi, _mm_unpackhi_epi32(rv, rv)));
+    g = _mm_packs_epi32(_mm_sub_epi32(cLo, _mm_unpacklo_epi32(gv, gv)),
+                        _mm_sub_epi32(cHi, _mm_unpackhi_epi32(gv, gv)));
+    b = _mm_packs_epi32(_mm_add_epi32(cLo, _mm_unpacklo_epi32(bu, bu)),
+                        _mm_add_epi32(cHi, _mm_unpackhi_epi32(bu, bu)));
+}
+
+static void yuyvRowSse2(const unsigned char *src, unsigned char *dst, int pixels)
+{
+    int i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i r0, g0, b0, r1, g1, b1;
+        yuyv8Sse2(_mm_loadu_si128((const __m128i *)(src)),      r0, g0, b0);
+        yuyv8Sse2(_mm_loadu_si128((const __m128i *)(src + 16)), r1, g1, b1);
+
+        // packus 饱和到 [0,255]，与 qBound 等价
+        unsigned char pr[16], pg[16], pb[16];
+        _mm_storeu_si128((__m128i *)pr, _mm_packus_epi16(r0, r1));
+        _mm_storeu_si128((__m128i *)pg, _mm_packus_epi16(g0, g1));
+        _mm_storeu_si128((__m128i *)pb, _mm_packus_epi16(b0, b1));
+        // SSE2 没有字节重排指令，交织写回由标量完成
+        for (int k = 0; k < 16; ++k) {
+            dst[3*k]     = pr[k];
+            dst[3*k + 1] = pg[k];
+            dst[3*k + 2] = pb[k];
+        }
+        src += 32;
+        dst += 48;
+    }
+    yuyvRowScalar(src, dst, pixels - i);
+}
+
+__attribute__((target("avx2")))
+static inline void yuyv16Avx2(__m256i in, __m256i &r, __m256i &g, __m256i &b)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+    const __m256i k16  = _mm256_set1_epi16(16);
+    const __m256i k128 = _mm256_set1_epi16(128);
+    const __m256i one  = _mm256_set1_epi16(1);
+    const __m256i kY   = _mm256_set1_epi32((128 << 16) | 298);
+    const __m256i kR   = _mm256_set1_epi32(409 << 16);
+    const __m256i kG   = _mm256_set1_epi32((208 << 16) | 100);
+    const __m256i kB   = _mm256_set1_epi32(516);
+
+    // 所有运算都在 128 位通道内，输出顺序与输入一致
+    __m256i y  = _mm256_sub_epi16(_mm256_and_si256(in, mask), k16);
+    __m256i uv = _mm256_sub_epi16(_mm256_srli_epi16(in, 8), k128);
+
+    __m256i cLo = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y, one), kY), 8);
+    __m256i cHi = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y, one), kY), 8);
+
+    __m256i rv = _mm256_srai_epi32(_mm256_madd_epi16(uv, kR), 8);
+    __m256i gv = _mm256_srai_epi32(_mm256_madd_epi16(uv, kG), 8);
+    __m256i bu = _mm256_srai_epi32(_mm256_madd_epi16(uv, kB), 8);
+
+    r = _mm256_packs_epi32(_mm256_add_epi32(cLo, _mm256_unpacklo_epi32(rv, rv)),
+                           _mm256_add_epi32(cHi, _mm256_unpackhi_epi32(rv, rv)));
+    g = _mm256_packs_epi32(_mm256_sub_epi32(cLo, _mm256_unpacklo_epi32(gv, gv)),
+                           _mm256_sub_epi32(cHi, _mm256_unpackhi_epi32(gv, gv)));
+    b = _mm256_packs_epi32(_mm256_add_epi32(cLo, _mm256_unpacklo_epi32(bu, bu)),
+                           _mm256_add_epi32(cHi, _mm256_unpackhi_epi32(bu, bu)));
+}
+
+// 16 个像素的平面 R/G/B -> 48 字节交织 RGB888
+__attribute__((target("avx2")))
+static inline void storeRgb16(unsigned char *dst, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    _mm_storeu_si128((__m128i *)(dst),
+        _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)),
+                     _mm_shuffle_epi8(b, b0)));
+    _mm_storeu_si128((__m128i *)(dst + 16),
+        _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)),
+                     _mm_shuffle_epi8(b, b1)));
+    _mm_storeu_si128((__m128i *)(dst + 32),
+        _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)),
+                     _mm_shuffle_epi8(b, b2)));
+}
+
+__attribute__((target("avx2")))
+static void yuyvRowAvx2(const unsigned char *src, unsigned char *dst, int pixels)
+{
+    int i = 0;
+    for (; i + 32 <= pixels; i += 32) {
+        __m256i r0, g0, b0, r1, g1, b1;
+        yuyv16Avx2(_mm256_loadu_si256((const __m256i *)(src)),      r0, g0, b0);
+        yuyv16Avx2(_mm256_loadu_si256((const __m256i *)(src + 32)), r1, g1, b1);
+
+        // packus 按 128 位通道交错，permute 恢复像素顺序
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), _MM_SHUFFLE(3, 1, 2, 0));
+
+        storeRgb16(dst,      _mm256_castsi256_si128(r), _mm256_castsi256_si128(g),
+                             _mm256_castsi256_si128(b));
+        storeRgb16(dst + 48, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1),
+                             _mm256_extracti128_si256(b, 1));
+        src += 64;
+        dst += 96;
+    }
+    yuyvRowSse2(src, dst, pixels - i);
+}
+
+static bool cpuHasSse2() { return true; }   // x86_64 基线指令集
+static bool cpuHasAvx2() { return __builtin_cpu_supports("avx2"); }
+#endif // YUV_HAVE_X86
+
+#ifdef YUV_HAVE_NEON
+static void yuyvRowNeon(const unsigned char *src, unsigned char *dst, int pixels)
+{
+    const int16x8_t  k16  = vdupq_n_s16(16);
+    const int16x8_t  k128 = vdupq_n_s16(128);
+    const int32x4_t  kRnd = vdupq_n_s32(128);
+
+    int i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        // val[0]=偶数像素 Y，val[1]=U，val[2]=奇数像素 Y，val[3]=V
+        uint8x8x4_t in = vld4_u8(src);
+        int16x8_t y0 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(in.val[0])), k16);
+        int16x8_t u  = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(in.val[1])), k128);
+        int16x8_t y1 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(in.val[2])), k16);
+        int16x8_t v  = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(in.val[3])), k128);
+
+        int32x4_t c0l = vshrq_n_s32(vmlal_n_s16(kRnd, vget_low_s16(y0),  298), 8);
+        int32x4_t c0h = vshrq_n_s32(vmlal_n_s16(kRnd, vget_high_s16(y0), 298), 8);
+        int32x4_t c1l = vshrq_n_s32(vmlal_n_s16(kRnd, vget_low_s16(y1),  298), 8);
+        int32x4_t c1h = vshrq_n_s32(vmlal_n_s16(kRnd, vget_high_s16(y1), 298), 8);
+
+        int32x4_t rvl = vshrq_n_s32(vmull_n_s16(vget_low_s16(v),  409), 8);
+        int32x4_t rvh = vshrq_n_s32(vmull_n_s16(vget_high_s16(v), 409), 8);
+        int32x4_t gvl = vshrq_n_s32(vmlal_n_s16(vmull_n_s16(vget_low_s16(u), 100),
+                                                vget_low_s16(v), 208), 8);
+        int32x4_t gvh = vshrq_n_s32(vmlal_n_s16(vmull_n_s16(vget_high_s16(u), 100),
+                                                vget_high_s16(v), 208), 8);
+        int32x4_t bul = vshrq_n_s32(vmull_n_s16(vget_low_s16(u),  516), 8);
+        int32x4_t buh = vshrq_n_s32(vmull_n_s16(vget_high_s16(u), 516), 8);
+
+#define YUV_NARROW(lo, hi) vqmovun_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)))
+        uint8x8_t r0 = YUV_NARROW(vaddq_s32(c0l, rvl), vaddq_s32(c0h, rvh));
+        uint8x8_t g0 = YUV_NARROW(vsubq_s32(c0l, gvl), vsubq_s32(c0h, gvh));
+        uint8x8_t b0 = YUV_NARROW(vaddq_s32(c0l, bul), vaddq_s32(c0h, buh));
+        uint8x8_t r1 = YUV_NARROW(vaddq_s32(c1l, rvl), vaddq_s32(c1h, rvh));
+        uint8x8_t g1 = YUV_NARROW(vsubq_s32(c1l, gvl), vsubq_s32(c1h, gvh));
+        uint8x8_t b1 = YUV_NARROW(vaddq_s32(c1l, bul), vaddq_s32(c1h, buh));
+#undef YUV_NARROW
+
+        // 偶/奇像素重新交错，vst3 负责 RGB 交织
+        uint8x8x2_t rz = vzip_u8(r0, r1);
+        uint8x8x2_t gz = vzip_u8(g0, g1);
+        uint8x8x2_t bz = vzip_u8(b0, b1);
+        uint8x16x3_t out;
+        out.val[0] = vcombine_u8(rz.val[0], rz.val[1]);
+        out.val[1] = vcombine_u8(gz.val[0], gz.val[1]);
+        out.val[2] = vcombine_u8(bz.val[0], bz.val[1]);
+        vst3q_u8(dst, out);
+
+        src += 32;
+        dst += 48;
+    }
+    yuyvRowScalar(src, dst, pixels - i);
+}
+#endif // YUV_HAVE_NEON
+
+// ---------------------------------------------------------------------------
+// 内核表与运行时选择：按优先级从高到低排列，标量版本总是可用
+// ---------------------------------------------------------------------------
+struct YuyvKernel {
+    const char  *name;
+    YuyvRowFunc  row;
+    bool       (*available)();
+};
+
+static bool alwaysAvailable() { return true; }
+
+static const YuyvKernel kKernels[] = {
+#ifdef YUV_HAVE_X86
+    { "avx2",   yuyvRowAvx2,   cpuHasAvx2 },
+    { "sse2",   yuyvRowSse2,   cpuHasSse2 },
+#endif
+#ifdef YUV_HAVE_NEON
+    { "neon",   yuyvRowNeon,   alwaysAvailable },
+#endif
+    { "scalar", yuyvRowScalar, alwaysAvailable },
+};
+static const int kKernelCount = sizeof(kKernels) / sizeof(kKernels[0]);
+
+static const YuyvKernel &selectKernel()
+{
+    for (int i = 0; i < kKernelCount; ++i) {
+        if (kKernels[i].available()) return kKernels[i];
+    }
+    return kKernels[kKernelCount - 1];
+}
+
+static const YuyvKernel &activeKernel()
+{
+    // 首次调用时检测一次，C++11 保证静态局部变量初始化线程安全
+    static const YuyvKernel &kernel = selectKernel();
+    return kernel;
+}
+
+static void convertWith(YuyvRowFunc row,
+                        const unsigned char *yuyv, int yuyvStride,
+                        unsigned char *rgb, int rgbStride,
+                        int width, int height)
+{
+    // 行间无填充时整帧当作一行处理，减少尾部标量处理
+    if (yuyvStride == width * 2 && rgbStride == width * 3) {
+        row(yuyv, rgb, width * height);
+        return;
+    }
+    for (int y = 0; y < height; ++y) {
+        row(yuyv + y * yuyvStride, rgb + y * rgbStride, width);
+    }
+}
+
+void yuyv_to_rgb888(const unsigned char *yuyv, int yuyvStride,
+                    unsigned char *rgb, int rgbStride,
+                    int width, int height)
+{
+    convertWith(activeKernel().row, yuyv, yuyvStride, rgb, rgbStride, width, height);
+}
+
+void nv12_to_rgb888(const unsigned char *y, int yStride,
+                    const unsigned char *uv, int uvStride,
+                    unsigned char *rgb, int rgbStride,
+                    int width, int height)
+{
+    for (int row = 0; row < height; ++row) {
+        const unsigned char *py  = y  + row * yStride;
+        const unsigned char *puv = uv + (row / 2) * uvStride;
+        unsigned char       *out = rgb + row * rgbStride;
+        for (int j = 0; j < width; j += 2) {
+            int u  = *puv++ - 128;
+            int v  = *puv++ - 128;
+            int c0 = (298 * (*py++ - 16) + 128) >> 8;
+            int c1 = (298 * (*py++ - 16) + 128) >> 8;
+            int rv = (409 * v) >> 8;
+            int gv = (100 * u + 208 * v) >> 8;
+            int bu = (516 * u) >> 8;
+            *out++ = qBound(0, c0 + rv, 255);
+            *out++ = qBound(0, c0 - gv, 255);
+            *out++ = qBound(0, c0 + bu, 255);
+            *out++ = qBound(0, c1 + rv, 255);
+            *out++ = qBound(0, c1 - gv, 255);
+            *out++ = qBound(0, c1 + bu, 255);
+        }
+    }
+}
+
+// 单个像素 -> 0xffRRGGBB，系数与 RGB888 版本一致
+static inline uint32_t yuvToRgb32(int y, int u, int v)
+{
+    int c = (298 * (y - 16) + 128) >> 8;
+    u -= 128;
+    v -= 128;
+    int r = qBound(0, c + ((409 * v) >> 8), 255);
+    int g = qBound(0, c - ((100 * u + 208 * v) >> 8), 255);
+    int b = qBound(0, c + ((516 * u) >> 8), 255);
+    return 0xff000000u | (r << 16) | (g << 8) | b;
+}
+
+// 目标像素中心对应的源坐标
+static inline int scaledSource(int d, int srcLen, int dstLen)
+{
+    return qMin((int)(((2LL * d + 1) * srcLen) / (2LL * dstLen)), srcLen - 1);
+}
+
+void yuyv_to_rgb32_scaled(const unsigned char *yuyv, int yuyvStride,
+                          int srcWidth, int srcHeight,
+                          unsigned char *dst, int dstStride,
+                          int dstWidth, int dstHeight)
+{
+    // 每列的 Y 字节偏移与该像素对所在的 U 字节偏移，整帧复用
+    std::vector<int> yOff(dstWidth), uvOff(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        int sx = scaledSource(x, srcWidth, dstWidth);
+        yOff[x]  = sx * 2;
+        uvOff[x] = (sx & ~1) * 2 + 1;
+    }
+    for (int y = 0; y < dstHeight; ++y) {
+        const unsigned char *row = yuyv + scaledSource(y, srcHeight, dstHeight) * yuyvStride;
+        uint32_t *out = (uint32_t*)(dst + y * dstStride);
+        for (int x = 0; x < dstWidth; ++x) {
+            const unsigned char *uv = row + uvOff[x];
+            out[x] = yuvToRgb32(row[yOff[x]], uv[0], uv[2]);
+        }
+    }
+}
+
+void nv12_to_rgb32_scaled(const unsigned char *y, int yStride,
+                          const unsigned char *uv, int uvStride,
+                          int srcWidth, int srcHeight,
+                          unsigned char *dst, int dstStride,
+                          int dstWidth, int dstHeight)
+{
+    std::vector<int> xs(dstWidth);
+    for (int x = 0; x < dstWidth; ++x) {
+        xs[x] = scaledSource(x, srcWidth, dstWidth);
+    }
+    for (int row = 0; row < dstHeight; ++row) {
+        int sy = scaledSource(row, srcHeight, dstHeight);
+        const unsigned char *py  = y  + sy * yStride;
+        const unsigned char *puv = uv + (sy / 2) * uvStride;
+        uint32_t *out = (uint32_t*)(dst + row * dstStride);
+        for (int x = 0; x < dstWidth; ++x) {
+            const unsigned char *c = puv + (xs[x] & ~1);
+            out[x] = yuvToRgb32(py[xs[x]], c[0], c[1]);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 亮度差分：YUYV 时用 0x00ff 掩掉 16 位中的色度字节，NV12 的 Y 平面全部参与
+// ---------------------------------------------------------------------------
+static unsigned long long lumaSadScalar(const unsigned char *a, const unsigned char *b,
+                                        int bytes, int ystep)
+{
+    unsigned long long sum = 0;
+    for (int i = 0; i < bytes; i += ystep) {
+        int d = a[i] - b[i];
+        sum += d < 0 ? -d : d;
+    }
+    return sum;
+}
+
+unsigned long long luma_sad(const unsigned char *a, const unsigned char *b,
+                            int bytes, int ystep)
+{
+    int i = 0;
+    unsigned long long sum = 0;
+#if defined(YUV_HAVE_X86)
+    const __m128i mask = _mm_set1_epi16(ystep == 2 ? 0x00ff : (short)0xffff);
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i x = _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + i)), mask);
+        __m128i y = _mm_and_si128(_mm_loadu_si128((const __m128i*)(b + i)), mask);
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(x, y));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    sum = lanes[0] + lanes[1];
+#elif defined(YUV_HAVE_NEON)
+    const uint8x16_t mask = ystep == 2 ? vreinterpretq_u8_u16(vdupq_n_u16(0x00ff))
+                                       : vdupq_n_u8(0xff);
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= bytes; i += 16) {
+        uint8x16_t d = vandq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), mask);
+        acc = vpadalq_u16(acc, vpaddlq_u8(d));
+    }
+    uint64x2_t wide = vpaddlq_u32(acc);
+    sum = vgetq_lane_u64(wide, 0) + vgetq_lane_u64(wide, 1);
+#endif
+    return sum + lumaSadScalar(a + i, b + i, bytes - i, ystep);
+}
+
+const char *yuyvKernelName()
+{
+#ifdef YUV_NEON_NOT_BUILT
+    return "scalar (NEON not compiled in)";
+#else
+    return activeKernel().name;
+#endif
+}
+
+void benchmarkYuyvConvert(int width, int height, int rounds)
+{
+    const int srcSize = width * height * 2;
+    const int dstSize = width * height * 3;
+    unsigned char *src = (unsigned char*)malloc(srcSize);
+    unsigned char *ref = (unsigned char*)malloc(dstSize);
+    unsigned char *dst = (unsigned char*)malloc(dstSize);
+    if (!src || !ref || !dst) {
+        qCritical() << "benchmarkYuyvConvert: malloc failed";
+        free(src); free(ref); free(dst);
+        return;
+    }
+
+    // 伪随机输入，覆盖饱和与负数移位等边界
+    unsigned int seed = 12345;
+    for (int i = 0; i < srcSize; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        src[i] = (unsigned char)(seed >> 16);
+    }
+    convertWith(yuyvRowScalar, src, width * 2, ref, width * 3, width, height);
+
+    qDebug() << "YUYV->RGB888 benchmark" << width << "x" << height
+             << "rounds:" << rounds << "active kernel:" << yuyvKernelName();
+    for (int k = 0; k < kKernelCount; ++k) {
+        const YuyvKernel &kernel = kKernels[k];
+        if (!kernel.available()) {
+            qDebug() << "  " << kernel.name << ": not supported on this CPU";
+            continue;
+        }
+        memset(dst, 0, dstSize);
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; ++r) {
+            convertWith(kernel.row, src, width * 2, dst, width * 3, width, height);
+        }
+        qint64 ns = qMax<qint64>(timer.nsecsElapsed(), 1);
+        double mps = double(width) * height * rounds * 1000.0 / ns;
+        bool exact = memcmp(dst, ref, dstSize) == 0;
+        qDebug() << "  " << kernel.name << ":" << QString::number(mps, 'f', 1) << "MP/s"
+                 << (exact ? "bit-exact" : "MISMATCH vs scalar");
+    }
+#ifdef YUV_NEON_NOT_BUILT
+    qDebug() << "   neon : not compiled in (build with -mfpu=neon)";
+#endif
+
+    free(src);
+    free(ref);
+    free(dst);
+}
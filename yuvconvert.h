@@ -0,0 +1,57 @@
+// yuvconvert.h
+#ifndef YUVCONVERT_H
+#define YUVCONVERT_H
+
+/**
+ * YUYV(4:2:2) -> RGB888 转换
+ *
+ * x86 上启动时按 CPU 能力选择内核（AVX2 / SSE2 / 标量）；ARM 上 NEON 由编译选项
+ * 决定（-mfpu=neon 时使用，程序即要求 CPU 支持 NEON），否则用标量版本。
+ * 所有向量内核与标量版本逐位一致。
+ *
+ * @param yuyv        源数据，每行 yuyvStride 字节
+ * @param rgb         目标数据，每行 rgbStride 字节
+ * @param width       像素宽度（须为偶数）
+ */
+void yuyv_to_rgb888(const unsigned char *yuyv, int yuyvStride,
+                    unsigned char *rgb, int rgbStride,
+                    int width, int height);
+
+/**
+ * NV12（Y 平面 + 交织 UV 平面，4:2:0）-> RGB888，系数与 YUYV 版本相同
+ * 用于协商到 NV12 模式的摄像头，目前只有标量实现
+ */
+void nv12_to_rgb888(const unsigned char *y, int yStride,
+                    const unsigned char *uv, int uvStride,
+                    unsigned char *rgb, int rgbStride,
+                    int width, int height);
+
+/**
+ * 转换与缩小一次完成：按目标尺寸对源图最近邻采样，直接输出 QImage::Format_RGB32
+ * （0xffRRGGBB），供预览使用，避免先转全分辨率 RGB 再 QImage::scaled
+ */
+void yuyv_to_rgb32_scaled(const unsigned char *yuyv, int yuyvStride,
+                          int srcWidth, int srcHeight,
+                          unsigned char *dst, int dstStride,
+                          int dstWidth, int dstHeight);
+void nv12_to_rgb32_scaled(const unsigned char *y, int yStride,
+                          const unsigned char *uv, int uvStride,
+                          int srcWidth, int srcHeight,
+                          unsigned char *dst, int dstStride,
+                          int dstWidth, int dstHeight);
+
+/**
+ * 两段同格式数据中亮度字节的绝对差之和（SSE2 / NEON）
+ * ystep 为 2 时按 YUYV 只取偶数字节，为 1 时按 NV12 的 Y 平面全部计算
+ */
+unsigned long long luma_sad(const unsigned char *a, const unsigned char *b,
+                            int bytes, int ystep);
+
+// 当前选用的内核名称，如 "avx2"、"neon"、"scalar"；ARM 上没带 NEON 编译时
+// 为 "scalar (NEON not compiled in)"
+const char *yuyvKernelName();
+
+// 对每个可用内核做吞吐测试（MP/s），并与标量结果逐字节比对，结果输出到日志
+void benchmarkYuyvConvert(int width, int height, int rounds);
+
+#endif // YUVCONVERT_H